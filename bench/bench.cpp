@@ -0,0 +1,408 @@
+/*
+ * bench
+ *
+ * Times insert, find (hit and miss), operator[], iteration, copy, erase
+ * and clear of ppstd::linked_hash_map (also on a ppstd::node_pool) and
+ * ppstd::dense_linked_hash_map, next to std::unordered_map, std::map and an
+ * insertion ordered std::vector with a std::unordered_map index.
+ *
+ * Every row reports the time and the global operator new calls per element,
+ * and the bytes held per element after the map is built (including the
+ * heap memory of std::string keys), next to what memory_usage() reports.
+ *
+ * usage: ./bench.out [max_n], the sizes run from 10 to max_n (1000000 by default,
+ * 10000000 at most).
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../include/linked_hash_map.hpp"
+#include "../include/dense_linked_hash_map.hpp"
+#include "../include/pool_allocator.hpp"
+
+namespace
+{
+
+std::size_t g_allocs = 0;
+std::size_t g_live_bytes = 0;
+
+// keeps the requested size in front of each block, so delete knows it
+const std::size_t header_size = 16;
+
+void* counted_new(std::size_t size)
+{
+    void* p = std::malloc(size + header_size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    *static_cast<std::size_t*>(p) = size;
+    ++g_allocs;
+    g_live_bytes += size;
+    return static_cast<char*>(p) + header_size;
+}
+
+void counted_delete(void* p) noexcept
+{
+    if (p != nullptr)
+    {
+        void* block = static_cast<char*>(p) - header_size;
+        g_live_bytes -= *static_cast<std::size_t*>(block);
+        std::free(block);
+    }
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return counted_new(size); }
+void* operator new[](std::size_t size) { return counted_new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return counted_new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void operator delete(void* p) noexcept { counted_delete(p); }
+void operator delete[](void* p) noexcept { counted_delete(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_delete(p); }
+
+namespace
+{
+
+// the insertion ordered baseline: the elements in a vector, erased ones are
+// only marked dead, and a std::unordered_map from the key to the position
+template <class K, class V>
+class vector_index
+{
+private:
+    std::vector<std::pair<K, V>> entries_;
+    std::vector<char> dead_;
+    std::unordered_map<K, std::size_t> index_;
+
+public:
+    bool emplace(const K& k, const V& v)
+    {
+        if (!index_.emplace(k, entries_.size()).second)
+        {
+            return false;
+        }
+        entries_.emplace_back(k, v);
+        dead_.push_back(0);
+        return true;
+    }
+
+    std::size_t count(const K& k) const { return index_.count(k); }
+
+    std::size_t erase(const K& k)
+    {
+        auto it = index_.find(k);
+        if (it == index_.end())
+        {
+            return 0;
+        }
+        dead_[it->second] = 1;
+        index_.erase(it);
+        return 1;
+    }
+
+    V& operator[](const K& k)
+    {
+        auto it = index_.find(k);
+        if (it != index_.end())
+        {
+            return entries_[it->second].second;
+        }
+        emplace(k, V());
+        return entries_.back().second;
+    }
+
+    void clear()
+    {
+        entries_.clear();
+        dead_.clear();
+        index_.clear();
+    }
+
+    template <class F>
+    void for_each(F&& fn) const
+    {
+        for (std::size_t i = 0; i < entries_.size(); ++i)
+        {
+            if (!dead_[i])
+            {
+                fn(entries_[i]);
+            }
+        }
+    }
+}; // class vector_index
+
+// all the maps of one row, and their copies, share this pool; it is released
+// between the rows, so each row starts without free blocks
+template <class K, class V>
+ppstd::node_pool& row_pool()
+{
+    static ppstd::node_pool pool(1024);
+    return pool;
+}
+
+template <class K, class V>
+using pool_alloc = ppstd::pool_allocator<std::pair<const K, V>>;
+
+template <class K, class V>
+class pooled_map : public ppstd::linked_hash_map<K, V, std::hash<K>, std::equal_to<K>, pool_alloc<K, V>>
+{
+public:
+    pooled_map()
+        : ppstd::linked_hash_map<K, V, std::hash<K>, std::equal_to<K>, pool_alloc<K, V>>(
+            pool_alloc<K, V>(row_pool<K, V>())) {}
+};
+
+template <class Map, class F>
+void for_each(const Map& m, F&& fn)
+{
+    for (const auto& kv : m)
+    {
+        fn(kv);
+    }
+}
+
+template <class K, class V, class F>
+void for_each(const vector_index<K, V>& m, F&& fn)
+{
+    m.for_each(fn);
+}
+
+
+struct Large
+{
+    std::uint64_t payload[32];
+};
+
+std::uint64_t mix(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+template <class K> K make_key(std::uint64_t i);
+
+template <>
+std::uint64_t make_key<std::uint64_t>(std::uint64_t i) { return mix(i); }
+
+// long enough to live on the heap, past the small string buffer
+template <>
+std::string make_key<std::string>(std::uint64_t i) { return "key:" + std::to_string(mix(i)); }
+
+template <class V> V make_value(std::uint64_t i);
+
+template <>
+std::uint64_t make_value<std::uint64_t>(std::uint64_t i) { return i; }
+
+template <>
+Large make_value<Large>(std::uint64_t i)
+{
+    Large v = {};
+    v.payload[0] = i;
+    return v;
+}
+
+// memory_usage().total() of one map per element, or -1 without memory_usage()
+template <class Map>
+auto reported_bytes(const Map& m, std::size_t n, int) -> decltype(m.memory_usage().total(), double())
+{
+    return n == 0 ? 0.0 : static_cast<double>(m.memory_usage().total()) / n;
+}
+
+template <class Map>
+double reported_bytes(const Map&, std::size_t, long) { return -1.0; }
+
+std::uint64_t checksum(std::uint64_t v) { return v; }
+std::uint64_t checksum(const Large& v) { return v.payload[0]; }
+
+// stops the compiler from dropping the loops
+volatile std::uint64_t g_sink = 0;
+
+struct Timer
+{
+    std::chrono::steady_clock::time_point start;
+    std::size_t allocs;
+
+    Timer() : start(std::chrono::steady_clock::now()), allocs(g_allocs) {}
+};
+
+void report(const char* map, const char* workload, std::size_t n, const char* op,
+    const Timer& timer, std::size_t ops, double bytes_per_entry, double reported_per_entry)
+{
+    const double ns = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - timer.start).count();
+    const double allocs = static_cast<double>(g_allocs - timer.allocs);
+    std::printf("%-22s %-16s %9zu %-10s %10.1f %10.2f %12.1f", map, workload, n, op,
+        ns / ops, allocs / ops, bytes_per_entry);
+    if (reported_per_entry < 0)
+    {
+        std::printf(" %12s\n", "-");
+    }
+    else
+    {
+        std::printf(" %12.1f\n", reported_per_entry);
+    }
+}
+
+template <class Map, class K, class V>
+void run(const char* name, const char* workload, std::size_t n,
+    const std::vector<K>& keys, const std::vector<K>& lookups, const std::vector<K>& misses)
+{
+    // small maps are built many times, so every row covers enough operations
+    const std::size_t reps = std::max<std::size_t>(1, (1u << 18) / n);
+    const std::size_t ops = reps * n;
+    std::uint64_t sum = 0;
+
+    std::vector<Map> maps(reps);
+    const std::size_t live_before = g_live_bytes;
+    Timer timer;
+    for (Map& m : maps)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            m.emplace(keys[i], make_value<V>(i));
+        }
+    }
+    const double bytes = static_cast<double>(g_live_bytes - live_before) / ops;
+    const double reported = reported_bytes(maps.front(), n, 0);
+    report(name, workload, n, "insert", timer, ops, bytes, reported);
+
+    timer = Timer();
+    for (const Map& m : maps)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            sum += m.count(lookups[i]);
+        }
+    }
+    report(name, workload, n, "find_hit", timer, ops, bytes, reported);
+
+    timer = Timer();
+    for (const Map& m : maps)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            sum += m.count(misses[i]);
+        }
+    }
+    report(name, workload, n, "find_miss", timer, ops, bytes, reported);
+
+    timer = Timer();
+    for (Map& m : maps)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            sum += checksum(m[lookups[i]]);
+        }
+    }
+    report(name, workload, n, "operator[]", timer, ops, bytes, reported);
+
+    timer = Timer();
+    for (const Map& m : maps)
+    {
+        for_each(m, [&sum](const std::pair<const K, V>& kv) { sum += checksum(kv.second); });
+    }
+    report(name, workload, n, "iterate", timer, ops, bytes, reported);
+
+    std::vector<Map> copies;
+    copies.reserve(reps);
+    timer = Timer();
+    for (const Map& m : maps)
+    {
+        copies.emplace_back(m);
+    }
+    report(name, workload, n, "copy", timer, ops, bytes, reported);
+
+    timer = Timer();
+    for (Map& m : copies)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            sum += m.erase(lookups[i]);
+        }
+    }
+    report(name, workload, n, "erase", timer, ops, bytes, reported);
+
+    timer = Timer();
+    for (Map& m : maps)
+    {
+        m.clear();
+    }
+    report(name, workload, n, "clear", timer, ops, bytes, reported);
+
+    g_sink = g_sink + sum;
+}
+
+template <class K, class V>
+void run_workload(const char* workload, std::size_t max_n)
+{
+    for (std::size_t n = 10; n <= max_n; n *= 10)
+    {
+        std::vector<K> keys, misses;
+        keys.reserve(n);
+        misses.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            keys.push_back(make_key<K>(i));
+            misses.push_back(make_key<K>(i + max_n));
+        }
+        // probing in the insertion order would favour the node maps,
+        // whose nodes are then visited in allocation order
+        std::vector<K> lookups(keys);
+        std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64(n));
+
+        run<ppstd::linked_hash_map<K, V>, K, V>("linked_hash_map", workload, n, keys, lookups, misses);
+        run<pooled_map<K, V>, K, V>("linked_hash_map+pool", workload, n, keys, lookups, misses);
+        row_pool<K, V>().release();
+        run<ppstd::dense_linked_hash_map<K, V>, K, V>("dense_linked_hash_map", workload, n, keys, lookups, misses);
+        run<std::unordered_map<K, V>, K, V>("std::unordered_map", workload, n, keys, lookups, misses);
+        run<std::map<K, V>, K, V>("std::map", workload, n, keys, lookups, misses);
+        run<vector_index<K, V>, K, V>("vector+index", workload, n, keys, lookups, misses);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t max_n = 1000000;
+    if (argc > 1)
+    {
+        max_n = std::min<std::size_t>(std::strtoull(argv[1], nullptr, 10), 10000000);
+    }
+
+    std::printf("%-22s %-16s %9s %-10s %10s %10s %12s %12s\n",
+        "map", "workload", "n", "op", "ns/op", "allocs/op", "bytes/entry", "reported");
+    run_workload<std::uint64_t, std::uint64_t>("u64->u64", max_n);
+    run_workload<std::string, std::uint64_t>("string->u64", max_n);
+    run_workload<std::uint64_t, Large>("u64->large(256B)", max_n);
+    return 0;
+}
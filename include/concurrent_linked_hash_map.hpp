@@ -0,0 +1,305 @@
+/*
+ * concurrent_linked_hash_map
+ *
+ * A thread-safe ppstd::linked_hash_map made of N independently locked shards,
+ * each with a reader/writer lock. A key always lives in the shard selected
+ * by its hash, so point operations on different shards run in parallel.
+ *
+ * Every inserted element is stamped with a global monotonic sequence number.
+ * Inside a shard the elements are in sequence order, so the insertion order
+ * across the shards is recovered by merging the shards by sequence number.
+ *
+ * std::shared_mutex is used in C++ 17, std::shared_timed_mutex in C++ 14,
+ * and a plain std::mutex (readers exclude each other too) in C++ 11.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_CONCURRENT_LINKED_HASH_MAP_H_
+#define PPSTD_CONCURRENT_LINKED_HASH_MAP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "linked_hash_map.hpp"
+
+#if defined(_MSVC_LANG) && _MSVC_LANG >= 201402L || __cplusplus >= 201402L
+#include <shared_mutex>
+#endif
+
+namespace ppstd
+{
+
+namespace detail
+{
+
+#if defined(_MSVC_LANG) && _MSVC_LANG >= 201703L || __cplusplus >= 201703L
+using SharedMutex = std::shared_mutex;
+using ReadLock = std::shared_lock<SharedMutex>;
+#elif defined(_MSVC_LANG) && _MSVC_LANG >= 201402L || __cplusplus >= 201402L
+using SharedMutex = std::shared_timed_mutex;
+using ReadLock = std::shared_lock<SharedMutex>;
+#else
+using SharedMutex = std::mutex;
+using ReadLock = std::unique_lock<SharedMutex>;
+#endif
+using WriteLock = std::unique_lock<SharedMutex>;
+
+template <typename T>
+struct Sequenced
+{
+    std::uint64_t seq;
+    T value;
+
+    template <typename... Args>
+    explicit Sequenced(std::uint64_t s, Args&&... args)
+        : seq{ s }, value(std::forward<Args>(args)...) {}
+};
+
+} // namespace detail
+
+
+template <class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>>
+class concurrent_linked_hash_map
+{
+private:
+    using ShardMap = linked_hash_map<Key, detail::Sequenced<T>, Hash, Pred>;
+
+    struct Shard
+    {
+        mutable detail::SharedMutex mutex;
+        ShardMap map;
+        // keeps the hot mutexes of neighbouring shards off one cache line
+        char padding[64];
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t shard_mask_;
+    std::atomic<std::uint64_t> seq_;
+    Hash hash_;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = size_t;
+
+    // the shard count is rounded up to a power of two,
+    // 0 means four shards per hardware thread
+    explicit concurrent_linked_hash_map(size_type shard_count = 0,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : shard_mask_{ 0 }, seq_{ 0 }, hash_(hf)
+    {
+        if (shard_count == 0)
+        {
+            shard_count = 4 * std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_type n = 1;
+        while (n < shard_count)
+        {
+            n <<= 1;
+        }
+        shards_.reset(new Shard[n]);
+        shard_mask_ = n - 1;
+        for (size_type i = 0; i < n; ++i)
+        {
+            ShardMap map(0, hf, eql);
+            shards_[i].map.swap(map);
+        }
+    }
+
+    concurrent_linked_hash_map(const concurrent_linked_hash_map&) = delete;
+    concurrent_linked_hash_map& operator=(const concurrent_linked_hash_map&) = delete;
+
+    ~concurrent_linked_hash_map() {}
+
+
+    size_type shard_count() const noexcept { return shard_mask_ + 1; }
+
+    // the sum over the shards, only a snapshot while writers are running
+    size_type size() const
+    {
+        size_type res = 0;
+        for (size_type i = 0; i <= shard_mask_; ++i)
+        {
+            detail::ReadLock lock(shards_[i].mutex);
+            res += shards_[i].map.size();
+        }
+        return res;
+    }
+
+    bool empty() const { return size() == 0; }
+
+
+    bool insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+
+    // returns whether the key was inserted
+    template <class... Args>
+    bool try_emplace(const key_type& k, Args&&... args)
+    {
+        const size_type h = hash_(k);
+        Shard& shard = shards_[shard_of_hash(h)];
+        detail::WriteLock lock(shard.mutex);
+        // the sequence number is taken under the shard lock,
+        // so each shard stays sorted by it
+        return shard.map.try_emplace_hashed(h, k, next_seq(), std::forward<Args>(args)...).second;
+    }
+
+    // an existing key keeps its position, as with linked_hash_map
+    template <class M>
+    bool insert_or_assign(const key_type& k, M&& obj)
+    {
+        const size_type h = hash_(k);
+        Shard& shard = shards_[shard_of_hash(h)];
+        detail::WriteLock lock(shard.mutex);
+        std::pair<typename ShardMap::iterator, bool> res = shard.map.try_emplace_hashed(
+            h, k, next_seq(), std::forward<M>(obj));
+        if (!res.second)
+        {
+            res.first->second.value = std::forward<M>(obj);
+        }
+        return res.second;
+    }
+
+    size_type erase(const key_type& k)
+    {
+        Shard& shard = shard_for(k);
+        detail::WriteLock lock(shard.mutex);
+        return shard.map.erase(k);
+    }
+
+    void clear()
+    {
+        for (size_type i = 0; i <= shard_mask_; ++i)
+        {
+            detail::WriteLock lock(shards_[i].mutex);
+            shards_[i].map.clear();
+        }
+    }
+
+
+    // copies the mapped value out, returns false if k is not there
+    bool find(const key_type& k, mapped_type& out) const
+    {
+        const size_type h = hash_(k);
+        const Shard& shard = shards_[shard_of_hash(h)];
+        detail::ReadLock lock(shard.mutex);
+        typename ShardMap::const_iterator it = shard.map.find(k, h);
+        if (it == shard.map.end())
+        {
+            return false;
+        }
+        out = it->second.value;
+        return true;
+    }
+
+    bool contains(const key_type& k) const
+    {
+        const size_type h = hash_(k);
+        const Shard& shard = shards_[shard_of_hash(h)];
+        detail::ReadLock lock(shard.mutex);
+        return shard.map.contains(k, h);
+    }
+
+    size_type count(const key_type& k) const { return contains(k) ? 1 : 0; }
+
+    // calls fn(mapped_type&) under the write lock of the shard,
+    // returns false if k is not there
+    template <class F>
+    bool visit(const key_type& k, F&& fn)
+    {
+        const size_type h = hash_(k);
+        Shard& shard = shards_[shard_of_hash(h)];
+        detail::WriteLock lock(shard.mutex);
+        typename ShardMap::iterator it = shard.map.find(k, h);
+        if (it == shard.map.end())
+        {
+            return false;
+        }
+        fn(it->second.value);
+        return true;
+    }
+
+
+    // calls fn(const key_type&, const mapped_type&) in the global insertion order,
+    // merging the shards by sequence number. All the shards are read locked
+    // for the whole walk, so fn must not call back into this map.
+    template <class F>
+    void for_each(F&& fn) const
+    {
+        using Cursor = std::pair<typename ShardMap::const_iterator, typename ShardMap::const_iterator>;
+
+        std::vector<detail::ReadLock> locks;
+        locks.reserve(shard_mask_ + 1);
+        std::vector<Cursor> heap;
+        heap.reserve(shard_mask_ + 1);
+        for (size_type i = 0; i <= shard_mask_; ++i)
+        {
+            locks.emplace_back(shards_[i].mutex);
+            if (!shards_[i].map.empty())
+            {
+                heap.emplace_back(shards_[i].map.begin(), shards_[i].map.end());
+            }
+        }
+
+        // a min-heap of the shard cursors by the sequence number of their heads
+        const auto later = [](const Cursor& lhs, const Cursor& rhs)
+        {
+            return lhs.first->second.seq > rhs.first->second.seq;
+        };
+        std::make_heap(heap.begin(), heap.end(), later);
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            Cursor& cur = heap.back();
+            fn(cur.first->first, cur.first->second.value);
+            if (++cur.first == cur.second)
+            {
+                heap.pop_back();
+            }
+            else
+            {
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+
+    // an ordinary linked_hash_map in the global insertion order
+    linked_hash_map<Key, T, Hash, Pred> snapshot() const
+    {
+        linked_hash_map<Key, T, Hash, Pred> res(0, hash_, shards_[0].map.key_eq());
+        for_each([&res](const key_type& k, const mapped_type& v) { res.insert({ k, v }); });
+        return res;
+    }
+
+private:
+    std::uint64_t next_seq() noexcept
+    {
+        return seq_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the low bits pick the shard, the shard map uses the high bits for its buckets.
+    // the shard maps get the same hash value, so each key is hashed only once
+    // not an overload of a key-taking function, which would be ambiguous for size_t keys
+    size_type shard_of_hash(size_type h) const noexcept
+    {
+        return (h ^ (h >> 17) ^ (h >> 31)) & shard_mask_;
+    }
+
+    Shard& shard_for(const key_type& k) { return shards_[shard_of_hash(hash_(k))]; }
+    const Shard& shard_for(const key_type& k) const { return shards_[shard_of_hash(hash_(k))]; }
+
+}; // class concurrent_linked_hash_map
+
+} // namespace ppstd
+
+#endif // PPSTD_CONCURRENT_LINKED_HASH_MAP_H_
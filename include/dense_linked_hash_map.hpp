@@ -0,0 +1,1090 @@
+/*
+ * dense_linked_hash_map
+ *
+ * The "ordered dense" storage of ppstd::linked_hash_map:
+ * the key value pairs are stored contiguously in insertion order,
+ * and an open-addressing index of small integer slots points into them,
+ * similar to CPython's compact dict.
+ *
+ * The lookup, insertion and erase APIs follow ppstd::linked_hash_map, so code
+ * that uses only those switches between the two by changing the type. The
+ * order operations, hints, node handles, the access order mode, transparent
+ * lookup, the precomputed-hash API, stats() and the Allocator parameter are
+ * only in ppstd::linked_hash_map.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_DENSE_LINKED_HASH_MAP_H_
+#define PPSTD_DENSE_LINKED_HASH_MAP_H_
+
+#include <cstdint>
+#include <new>
+#include <tuple>
+
+#include "linked_hash_map.hpp"
+
+namespace ppstd
+{
+
+template <class Key, class T, class Hash, class Pred>
+class dense_linked_hash_map;
+
+namespace detail
+{
+
+// one slot of the entry vector, erased entries stay as tombstones
+// until the next compaction
+template <typename V>
+struct DenseEntry
+{
+    std::size_t hash;
+    bool live;
+    typename std::aligned_storage<sizeof(V), alignof(V)>::type storage;
+
+    V& value() noexcept { return *reinterpret_cast<V*>(&storage); }
+    const V& value() const noexcept { return *reinterpret_cast<const V*>(&storage); }
+};
+
+template <typename K, typename V>
+class DenseIterator
+{
+private:
+    using EntryType = DenseEntry<std::pair<K, typename std::remove_const<V>::type>>;
+    using Entry = typename std::conditional<
+        std::is_const<V>::value,
+        const EntryType,
+        EntryType
+        >::type;
+    using Value = typename std::conditional<
+        std::is_const<V>::value,
+        const std::pair<K, typename std::remove_const<V>::type>,
+        std::pair<K, V>
+        >::type;
+
+    template <typename, typename> friend class DenseIterator;
+    template <class, class, class, class> friend class ppstd::dense_linked_hash_map;
+
+    Entry* entry_;
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::pair<K, typename std::remove_const<V>::type>;
+    using difference_type = std::ptrdiff_t;
+    using reference = Value&;
+    using pointer = Value*;
+
+    explicit DenseIterator(Entry* const entry = nullptr) : entry_{ entry } {}
+
+    // iterator -> const_iterator
+    template <typename U, typename = typename std::enable_if<
+        std::is_const<V>::value && std::is_same<U, typename std::remove_const<V>::type>::value>::type>
+    DenseIterator(const DenseIterator<K, U>& rhs) : entry_{ rhs.entry_ } {}
+
+    // the entry after the last one is a live sentinel,
+    // so skipping the tombstones always stops at end()
+    DenseIterator& operator++()
+    {
+        do
+        {
+            ++entry_;
+        } while (!entry_->live);
+        return *this;
+    }
+
+    DenseIterator operator++(int)
+    {
+        DenseIterator orig(*this);
+        ++(*this);
+        return orig;
+    }
+
+    DenseIterator& operator--()
+    {
+        do
+        {
+            --entry_;
+        } while (!entry_->live);
+        return *this;
+    }
+
+    DenseIterator operator--(int)
+    {
+        DenseIterator orig(*this);
+        --(*this);
+        return orig;
+    }
+
+    reference operator*() const { return entry_->value(); }
+    pointer operator->() const { return &entry_->value(); }
+
+    friend bool operator==(const DenseIterator& lhs, const DenseIterator& rhs)
+    {
+        return lhs.entry_ == rhs.entry_;
+    }
+
+    friend bool operator!=(const DenseIterator& lhs, const DenseIterator& rhs)
+    {
+        return !(lhs == rhs);
+    }
+}; // class DenseIterator
+
+} // namespace detail
+
+
+template <class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>>
+class dense_linked_hash_map
+{
+private:
+    using Entry = detail::DenseEntry<std::pair<const Key, T>>;
+    using Slot = std::uint32_t;
+    using Index = std::vector<Slot>;
+    // the pairs are moved only when neither move can throw, otherwise copied
+    using NothrowMove = std::integral_constant<bool,
+        std::is_nothrow_move_constructible<Key>::value &&
+        std::is_nothrow_move_constructible<T>::value>;
+
+    enum : Slot { empty_slot = 0xFFFFFFFFu, deleted_slot = 0xFFFFFFFEu };
+
+    // capacity_ + 1 entries, entries_[count_] is the live sentinel of end()
+    Entry* entries_;
+    // entries in use, including tombstones
+    std::size_t count_;
+    std::size_t capacity_;
+    std::size_t size_;
+    // the sum of the mixed hash values of the keys, see key_fingerprint()
+    std::uint64_t fingerprint_;
+    // the first live entry, tombstones before it are skipped by begin()
+    std::size_t head_;
+    // open addressing with linear probing, the size is zero or a power of two
+    Index index_;
+    std::size_t shift_;
+    float max_load_factor_;
+    Hash hash_;
+    Pred eq_;
+    // with positional_index(true), a Fenwick tree over the liveness of the
+    // capacity_ entries, so nth() and rank() skip the tombstones in O(log n)
+    bool positional_index_;
+    Index live_counts_;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = detail::DenseIterator<const key_type, mapped_type>;
+    using const_iterator = detail::DenseIterator<const key_type, const mapped_type>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+
+    dense_linked_hash_map()
+        noexcept(
+            std::is_nothrow_default_constructible<hasher>::value &&
+            std::is_nothrow_default_constructible<key_equal>::value)
+        : entries_{ empty_entries() }, count_{ 0 }, capacity_{ 0 }, size_{ 0 }, fingerprint_{ 0 }, head_{ 0 },
+        shift_{ 0 }, max_load_factor_{ 2.0f / 3.0f }, positional_index_{ false } {}
+
+    explicit dense_linked_hash_map(size_type n, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal())
+        : entries_{ empty_entries() }, count_{ 0 }, capacity_{ 0 }, size_{ 0 }, fingerprint_{ 0 }, head_{ 0 },
+        shift_{ 0 }, max_load_factor_{ 2.0f / 3.0f }, hash_(hf), eq_(eql), positional_index_{ false }
+    {
+        if (n > 0)
+        {
+            rehash(n);
+        }
+    }
+
+    template <class InputIterator>
+    dense_linked_hash_map(InputIterator first, InputIterator last,
+        size_type n = 0, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal()) : dense_linked_hash_map(n, hf, eql)
+    {
+        insert(first, last);
+    }
+
+    dense_linked_hash_map(const dense_linked_hash_map& rhs)
+        : dense_linked_hash_map(0, rhs.hash_, rhs.eq_)
+    {
+        max_load_factor_ = rhs.max_load_factor_;
+        positional_index_ = rhs.positional_index_;
+        reserve(rhs.size());
+        insert(rhs.begin(), rhs.end());
+    }
+
+    dense_linked_hash_map(dense_linked_hash_map&& rhs)
+        noexcept(
+            std::is_nothrow_move_constructible<hasher>::value &&
+            std::is_nothrow_move_constructible<key_equal>::value) : dense_linked_hash_map()
+    {
+        swap(rhs);
+    }
+
+    dense_linked_hash_map(std::initializer_list<value_type> ilist, size_type n = 0,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : dense_linked_hash_map(n, hf, eql)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    dense_linked_hash_map(size_type n) : dense_linked_hash_map(n, hasher(), key_equal()) {}
+
+    dense_linked_hash_map(size_type n, const hasher& hf) : dense_linked_hash_map(n, hf, key_equal()) {}
+
+    template <class InputIterator>
+    dense_linked_hash_map(InputIterator f, InputIterator l, size_type n)
+        : dense_linked_hash_map(f, l, n, hasher(), key_equal()) {}
+
+    template <class InputIterator>
+    dense_linked_hash_map(InputIterator f, InputIterator l, size_type n, const hasher& hf)
+        : dense_linked_hash_map(f, l, n, hf, key_equal()) {}
+
+    dense_linked_hash_map(std::initializer_list<value_type> il, size_type n)
+        : dense_linked_hash_map(il, n, hasher(), key_equal()) {}
+
+    dense_linked_hash_map(std::initializer_list<value_type> il, size_type n, const hasher& hf)
+        : dense_linked_hash_map(il, n, hf, key_equal()) {}
+
+    ~dense_linked_hash_map()
+    {
+        destroy_values();
+        free_entries(entries_);
+    }
+
+    dense_linked_hash_map& operator=(dense_linked_hash_map rhs)
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    dense_linked_hash_map& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type max_size() const noexcept { return deleted_slot - 1; }
+
+
+    iterator begin() noexcept { return iterator(entries_ + head_); }
+    iterator end() noexcept { return iterator(entries_ + count_); }
+    const_iterator begin() const noexcept { return const_iterator(entries_ + head_); }
+    const_iterator end() const noexcept { return const_iterator(entries_ + count_); }
+    const_iterator cbegin() const noexcept { return const_iterator(entries_ + head_); }
+    const_iterator cend() const noexcept { return const_iterator(entries_ + count_); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+    // the i-th element of the order, end() for i >= size(). Both are O(1) while
+    // there are no tombstones; otherwise they are O(log n) with positional_index(true),
+    // and a scan of the entries without it
+    iterator nth(size_type i) noexcept { return iterator(entries_ + nth_entry(i)); }
+    const_iterator nth(size_type i) const noexcept { return const_iterator(entries_ + nth_entry(i)); }
+
+    // the number of elements before it, size() for end()
+    size_type rank(const_iterator it) const noexcept
+    {
+        const size_type pos = it.entry_ - entries_;
+        if (count_ == size_)
+        {
+            return pos;
+        }
+        size_type res = 0;
+        if (positional_index_)
+        {
+            for (size_type k = pos; k > 0; k &= k - 1)
+            {
+                res += live_counts_[k - 1];
+            }
+            return res;
+        }
+        for (size_type i = head_; i < pos; ++i)
+        {
+            res += entries_[i].live ? 1 : 0;
+        }
+        return res;
+    }
+
+    // costs one 32-bit counter per entry, and an O(log n) update in erase()
+    // and each insertion; off by default
+    bool positional_index() const noexcept { return positional_index_; }
+
+    void positional_index(bool enabled)
+    {
+        Index counts;
+        if (enabled)
+        {
+            counts.assign(capacity_, 0);
+            for (size_type i = head_; i < count_; ++i)
+            {
+                counts[i] = entries_[i].live ? 1 : 0;
+            }
+            sum_live_counts(counts);
+        }
+        live_counts_.swap(counts);
+        positional_index_ = enabled;
+    }
+
+    // k contiguous sub-ranges of the order in O(k), e.g. for parallel_for_each;
+    // some may be empty. A cut in a run of tombstones moves to the next live entry
+    std::vector<std::pair<iterator, iterator>> chunks(size_type k)
+    {
+        return chunks_of<iterator>(k);
+    }
+
+    std::vector<std::pair<const_iterator, const_iterator>> chunks(size_type k) const
+    {
+        return chunks_of<const_iterator>(k);
+    }
+
+
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+        // the same as linked_hash_map: new entries always go to the end
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        const size_type h = hash_(value.first);
+        const size_type pos = find_entry(value.first, h);
+        if (pos != npos())
+        {
+            return std::pair<iterator, bool>{iterator(entries_ + pos), false};
+        }
+        return std::pair<iterator, bool>{iterator(append(h, value)), true};
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        const size_type h = hash_(value.first);
+        const size_type pos = find_entry(value.first, h);
+        if (pos != npos())
+        {
+            return std::pair<iterator, bool>{iterator(entries_ + pos), false};
+        }
+        return std::pair<iterator, bool>{iterator(append(h, std::move(value))), true};
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    // the mapped value is constructed from args only if k is not there yet
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+    {
+        return try_emplace_impl(k, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+    {
+        return try_emplace_impl(std::move(k), std::forward<Args>(args)...);
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+    {
+        return insert_or_assign_impl(k, std::forward<M>(obj));
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj)
+    {
+        return insert_or_assign_impl(std::move(k), std::forward<M>(obj));
+    }
+
+
+    hasher hash_function() const { return hash_; }
+    key_equal key_eq() const { return eq_; }
+
+
+    iterator erase(const_iterator position)
+    {
+        const size_type pos = position.entry_ - entries_;
+        iterator res(entries_ + pos);
+        ++res;
+        erase_entry(pos);
+        return res;
+    }
+
+    iterator erase(iterator position)
+    {
+        return erase(const_iterator(position));
+    }
+
+    size_type erase(const key_type& k)
+    {
+        const size_type pos = find_entry(k, hash_(k));
+        if (pos == npos())
+        {
+            return 0;
+        }
+        erase_entry(pos);
+        return 1;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        while (first != last)
+        {
+            first = erase(first);
+        }
+        return iterator(entries_ + (last.entry_ - entries_));
+    }
+
+    void clear() noexcept
+    {
+        if (capacity_ == 0)
+        {
+            return;
+        }
+        destroy_values();
+        std::fill(index_.begin(), index_.end(), static_cast<Slot>(empty_slot));
+        count_ = size_ = head_ = 0;
+        fingerprint_ = 0;
+        entries_[0].live = true;
+        std::fill(live_counts_.begin(), live_counts_.end(), 0);
+    }
+
+    linked_hash_map_memory memory_usage() const noexcept
+    {
+        linked_hash_map_memory res = linked_hash_map_memory();
+        res.buckets = (index_.capacity() + live_counts_.capacity()) * sizeof(Slot);
+        res.node_overhead = size_ * node_overhead_bytes();
+        res.payload = size_ * sizeof(value_type);
+        // the entry array has one more entry, the sentinel of end()
+        res.spare = capacity_ == 0 ? 0 : (capacity_ + 1 - size_) * sizeof(Entry);
+        return res;
+    }
+
+    // the bytes of an entry beyond its key value pair, the index slots not included
+    static constexpr size_type node_overhead_bytes() { return sizeof(Entry) - sizeof(value_type); }
+
+    // drops the tombstones left by erase(), invalidates the iterators
+    void compact()
+    {
+        if (count_ != size_)
+        {
+            relayout(index_.size());
+        }
+    }
+
+
+    void swap(dense_linked_hash_map& rhs) noexcept
+    {
+        using std::swap;
+        swap(entries_, rhs.entries_);
+        swap(count_, rhs.count_);
+        swap(capacity_, rhs.capacity_);
+        swap(size_, rhs.size_);
+        swap(fingerprint_, rhs.fingerprint_);
+        swap(head_, rhs.head_);
+        swap(index_, rhs.index_);
+        swap(shift_, rhs.shift_);
+        swap(max_load_factor_, rhs.max_load_factor_);
+        swap(hash_, rhs.hash_);
+        swap(eq_, rhs.eq_);
+        swap(positional_index_, rhs.positional_index_);
+        swap(live_counts_, rhs.live_counts_);
+    }
+
+
+    iterator find(const key_type& k)
+    {
+        const size_type pos = find_entry(k, hash_(k));
+        return pos == npos() ? end() : iterator(entries_ + pos);
+    }
+
+    const_iterator find(const key_type& k) const
+    {
+        const size_type pos = find_entry(k, hash_(k));
+        return pos == npos() ? end() : const_iterator(entries_ + pos);
+    }
+
+    size_type count(const key_type& k) const { return find_entry(k, hash_(k)) == npos() ? 0 : 1; }
+
+    bool contains(const key_type& k) const { return find_entry(k, hash_(k)) != npos(); }
+
+    // the batched find of linked_hash_map: the index slots and then the entries
+    // of a batch are prefetched before any key is probed
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out)
+    {
+        find_batched(first, last, [this, &out](size_type pos)
+        {
+            *out++ = pos != npos() ? iterator(entries_ + pos) : end();
+        });
+        return out;
+    }
+
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const
+    {
+        find_batched(first, last, [this, &out](size_type pos)
+        {
+            *out++ = pos != npos() ? const_iterator(entries_ + pos) : end();
+        });
+        return out;
+    }
+
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator contains_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const
+    {
+        find_batched(first, last, [&out](size_type pos) { *out++ = pos != npos(); });
+        return out;
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        iterator lower_it = find(k);
+        iterator upper_it = lower_it;
+        if (upper_it != end())
+        {
+            ++upper_it;
+        }
+        return std::pair<iterator, iterator>{lower_it, upper_it};
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        const_iterator lower_it = find(k);
+        const_iterator upper_it = lower_it;
+        if (upper_it != end())
+        {
+            ++upper_it;
+        }
+        return std::pair<const_iterator, const_iterator>{lower_it, upper_it};
+    }
+
+
+    mapped_type& operator[](const key_type& k)
+    {
+        return try_emplace_impl(k).first->second;
+    }
+
+    mapped_type& operator[](key_type&& k)
+    {
+        return try_emplace_impl(std::move(k)).first->second;
+    }
+
+
+    mapped_type& at(const key_type& k)
+    {
+        const size_type pos = find_entry(k, hash_(k));
+        if (pos == npos())
+        {
+            throw std::out_of_range("dense_linked_hash_map::at: key not found");
+        }
+        return entries_[pos].value().second;
+    }
+
+    const mapped_type& at(const key_type& k) const
+    {
+        const size_type pos = find_entry(k, hash_(k));
+        if (pos == npos())
+        {
+            throw std::out_of_range("dense_linked_hash_map::at: key not found");
+        }
+        return entries_[pos].value().second;
+    }
+
+
+    // the "buckets" are the slots of the open addressing index
+    size_type bucket_count() const noexcept { return index_.size(); }
+    size_type max_bucket_count() const noexcept { return index_.max_size(); }
+
+    size_type bucket_size(size_type n) const { return index_[n] < deleted_slot ? 1 : 0; }
+
+    size_type bucket(const key_type& k) const
+    {
+        return index_.empty() ? 0 : home_slot(hash_(k), shift_);
+    }
+
+
+    float load_factor() const noexcept
+    {
+        return index_.empty() ? 0.0f : static_cast<float>(size_) / index_.size();
+    }
+
+    float max_load_factor() const noexcept { return max_load_factor_; }
+
+    // an open addressing index cannot go over 1, z is clamped to [0.25, 0.875]
+    void max_load_factor(float z)
+    {
+        max_load_factor_ = std::min(std::max(z, 0.25f), 0.875f);
+        rehash(0);
+    }
+
+    void rehash(size_type n)
+    {
+        const size_type slots = std::max(n, index_size_for(size_));
+        size_type count = detail::min_bucket_count();
+        while (count < slots)
+        {
+            count <<= 1;
+        }
+        if (count != index_.size() || count_ != size_)
+        {
+            relayout(count);
+        }
+    }
+
+    void reserve(size_type n)
+    {
+        if (n > capacity_)
+        {
+            relayout(index_size_for(n));
+        }
+    }
+
+    // the smallest index and entry array for the size, drops the tombstones
+    void shrink_to_fit()
+    {
+        rehash(0);
+    }
+
+
+    // the key fingerprint of linked_hash_map
+    std::uint64_t key_fingerprint() const noexcept { return fingerprint_; }
+
+    friend bool operator==(const dense_linked_hash_map& lhs, const dense_linked_hash_map& rhs)
+    {
+        return lhs.size_ == rhs.size_ && lhs.same_fingerprint(rhs) &&
+            std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    // each key of lhs is probed in rhs, with its stored hash value when the hasher is stateless
+    friend bool equal_unordered(const dense_linked_hash_map& lhs, const dense_linked_hash_map& rhs)
+    {
+        if (lhs.size_ != rhs.size_ || !lhs.same_fingerprint(rhs))
+        {
+            return false;
+        }
+        for (size_type i = lhs.head_; i < lhs.count_; ++i)
+        {
+            const Entry& e = lhs.entries_[i];
+            if (!e.live)
+            {
+                continue;
+            }
+            const size_type pos = rhs.find_entry(e.value().first,
+                std::is_empty<Hash>::value ? e.hash : rhs.hash_(e.value().first));
+            if (pos == npos() || !(rhs.entries_[pos].value().second == e.value().second))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const dense_linked_hash_map& lhs, const dense_linked_hash_map& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend void swap(dense_linked_hash_map& lhs, dense_linked_hash_map& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+private:
+    static constexpr size_type npos() { return static_cast<size_type>(-1); }
+
+    bool same_fingerprint(const dense_linked_hash_map& rhs) const noexcept
+    {
+        return !std::is_empty<Hash>::value || fingerprint_ == rhs.fingerprint_;
+    }
+
+    template <class Iter>
+    std::vector<std::pair<Iter, Iter>> chunks_of(size_type k) const
+    {
+        k = std::max<size_type>(k, 1);
+        std::vector<std::pair<Iter, Iter>> res;
+        res.reserve(k);
+        const size_type span = count_ - head_;
+        size_type first = head_;
+        for (size_type i = 1; i <= k; ++i)
+        {
+            size_type last = head_ + span / k * i + span % k * i / k;
+            while (!entries_[last].live)
+            {
+                ++last;
+            }
+            res.emplace_back(Iter(entries_ + first), Iter(entries_ + last));
+            first = last;
+        }
+        return res;
+    }
+
+    // shared by all the empty maps, so that begin() == end() without allocating
+    static Entry* empty_entries() noexcept
+    {
+        static Entry sentinel{ 0, true, {} };
+        return &sentinel;
+    }
+
+    // tested by address rather than by capacity, so the compiler sees that the
+    // sentinel never reaches delete[]
+    static void free_entries(Entry* entries) noexcept
+    {
+        if (entries != empty_entries())
+        {
+            delete[] entries;
+        }
+    }
+
+    static size_type home_slot(size_type h, size_type shift) noexcept
+    {
+        return (h * detail::hash_multiplier()) >> shift;
+    }
+
+    size_type index_size_for(size_type n) const
+    {
+        size_type count = detail::min_bucket_count();
+        while (static_cast<size_type>(count * max_load_factor_) < n)
+        {
+            count <<= 1;
+        }
+        return count;
+    }
+
+    size_type nth_entry(size_type i) const noexcept
+    {
+        if (i >= size_)
+        {
+            return count_;
+        }
+        if (count_ == size_)
+        {
+            return i;
+        }
+        if (positional_index_)
+        {
+            // the longest prefix of the entries with at most i live ones,
+            // its end is the i-th live entry
+            size_type step = 1;
+            while (step * 2 <= capacity_)
+            {
+                step *= 2;
+            }
+            size_type pos = 0;
+            for (; step > 0; step >>= 1)
+            {
+                if (pos + step <= capacity_ && live_counts_[pos + step - 1] <= i)
+                {
+                    pos += step;
+                    i -= live_counts_[pos - 1];
+                }
+            }
+            return pos;
+        }
+        size_type pos = head_;
+        for (;; ++pos)
+        {
+            if (entries_[pos].live && i-- == 0)
+            {
+                return pos;
+            }
+        }
+    }
+
+    // turns counts of single entries into the Fenwick tree in O(n)
+    static void sum_live_counts(Index& counts) noexcept
+    {
+        for (size_type i = 0; i < counts.size(); ++i)
+        {
+            const size_type parent = i | (i + 1);
+            if (parent < counts.size())
+            {
+                counts[parent] += counts[i];
+            }
+        }
+    }
+
+    // delta is 1 or Slot(-1), the unsigned sums wrap back as they should
+    void count_live(size_type pos, Slot delta) noexcept
+    {
+        for (; pos < live_counts_.size(); pos |= pos + 1)
+        {
+            live_counts_[pos] += delta;
+        }
+    }
+
+    void destroy_values() noexcept
+    {
+        for (size_type i = head_; i < count_; ++i)
+        {
+            if (entries_[i].live)
+            {
+                entries_[i].value().~value_type();
+            }
+        }
+    }
+
+    size_type find_entry(const key_type& k, size_type h) const
+    {
+        if (index_.empty())
+        {
+            return npos();
+        }
+        const size_type mask = index_.size() - 1;
+        for (size_type i = home_slot(h, shift_);; i = (i + 1) & mask)
+        {
+            const Slot s = index_[i];
+            if (s == empty_slot)
+            {
+                return npos();
+            }
+            if (s != deleted_slot && entries_[s].hash == h && eq_(entries_[s].value().first, k))
+            {
+                return s;
+            }
+        }
+    }
+
+    template <class ForwardIterator, class F>
+    void find_batched(ForwardIterator first, ForwardIterator last, F fn) const
+    {
+        size_type hashes[detail::bulk_batch_size()];
+        while (first != last)
+        {
+            ForwardIterator batch = first;
+            size_type n = 0;
+            for (; n < detail::bulk_batch_size() && first != last; ++n, ++first)
+            {
+                hashes[n] = hash_(*first);
+                if (!index_.empty())
+                {
+                    detail::prefetch(&index_[home_slot(hashes[n], shift_)]);
+                }
+            }
+            if (!index_.empty())
+            {
+                for (size_type i = 0; i < n; ++i)
+                {
+                    const Slot s = index_[home_slot(hashes[i], shift_)];
+                    if (s < deleted_slot)
+                    {
+                        detail::prefetch(&entries_[s]);
+                    }
+                }
+            }
+            for (size_type i = 0; i < n; ++i, ++batch)
+            {
+                fn(find_entry(*batch, hashes[i]));
+            }
+        }
+    }
+
+    // the index slot that refers to the entry at pos, found by the cached hash
+    size_type slot_of(size_type pos) const noexcept
+    {
+        const size_type mask = index_.size() - 1;
+        size_type i = home_slot(entries_[pos].hash, shift_);
+        while (index_[i] != pos)
+        {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void place(size_type h, Slot pos) noexcept
+    {
+        const size_type mask = index_.size() - 1;
+        size_type i = home_slot(h, shift_);
+        while (index_[i] < deleted_slot)
+        {
+            i = (i + 1) & mask;
+        }
+        index_[i] = pos;
+    }
+
+    template <class K, class... Args>
+    std::pair<iterator, bool> try_emplace_impl(K&& k, Args&&... args)
+    {
+        const size_type h = hash_(k);
+        const size_type pos = find_entry(k, h);
+        if (pos != npos())
+        {
+            return std::pair<iterator, bool>{iterator(entries_ + pos), false};
+        }
+        return std::pair<iterator, bool>{iterator(append(h, std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(k)),
+            std::forward_as_tuple(std::forward<Args>(args)...))), true};
+    }
+
+    template <class K, class M>
+    std::pair<iterator, bool> insert_or_assign_impl(K&& k, M&& obj)
+    {
+        const size_type h = hash_(k);
+        const size_type pos = find_entry(k, h);
+        if (pos != npos())
+        {
+            entries_[pos].value().second = std::forward<M>(obj);
+            return std::pair<iterator, bool>{iterator(entries_ + pos), false};
+        }
+        return std::pair<iterator, bool>{iterator(append(h, std::forward<K>(k), std::forward<M>(obj))), true};
+    }
+
+    template <class... Args>
+    Entry* append(size_type h, Args&&... args)
+    {
+        if (count_ == capacity_)
+        {
+            // compact in place when enough of the entries are tombstones,
+            // otherwise grow, which drops the tombstones as well
+            const size_type tombstones = count_ - size_;
+            relayout(tombstones > 0 && tombstones >= capacity_ / 4 ?
+                index_.size() : std::max(index_.size() * 2, detail::min_bucket_count()));
+        }
+        Entry* entry = entries_ + count_;
+        ::new (static_cast<void*>(&entry->storage)) value_type(std::forward<Args>(args)...);
+        entry->hash = h;
+        entry->live = true;
+        place(h, static_cast<Slot>(count_));
+        if (positional_index_)
+        {
+            count_live(count_, 1);
+        }
+        ++count_;
+        ++size_;
+        fingerprint_ += detail::fingerprint_mix(h);
+        entries_[count_].live = true;
+        return entry;
+    }
+
+    void erase_entry(size_type pos) noexcept
+    {
+        index_[slot_of(pos)] = deleted_slot;
+        fingerprint_ -= detail::fingerprint_mix(entries_[pos].hash);
+        entries_[pos].value().~value_type();
+        entries_[pos].live = false;
+        if (positional_index_)
+        {
+            count_live(pos, static_cast<Slot>(-1));
+        }
+        --size_;
+        if (pos == head_)
+        {
+            while (!entries_[head_].live)
+            {
+                ++head_;
+            }
+        }
+    }
+
+    // moving out of a const key is fine, the entry is destroyed right after
+    static void relocate(void* to, value_type& from, std::true_type) noexcept
+    {
+        ::new (to) value_type(std::move(const_cast<key_type&>(from.first)), std::move(from.second));
+    }
+
+    static void relocate(void* to, const value_type& from, std::false_type)
+    {
+        ::new (to) value_type(from);
+    }
+
+    // moves the live entries in order to a fresh entry vector and rebuilds an index
+    // of the given size; if a copy throws, the old entries are still all there
+    void relayout(size_type slots)
+    {
+        size_type shift = sizeof(size_type) * CHAR_BIT;
+        for (size_type count = slots; count > 1; count >>= 1)
+        {
+            --shift;
+        }
+        const size_type capacity = std::max<size_type>(size_,
+            std::min<size_type>(static_cast<size_type>(slots * max_load_factor_), slots - 1));
+        Index index(slots, static_cast<Slot>(empty_slot));
+        Index counts(positional_index_ ? capacity : 0, 0);
+        Entry* fresh = new Entry[capacity + 1];
+
+        size_type n = 0;
+        try
+        {
+            for (size_type i = head_; i < count_; ++i)
+            {
+                if (entries_[i].live)
+                {
+                    relocate(&fresh[n].storage, entries_[i].value(), NothrowMove());
+                    fresh[n].hash = entries_[i].hash;
+                    fresh[n].live = true;
+                    ++n;
+                }
+            }
+        }
+        catch (...)
+        {
+            for (size_type i = 0; i < n; ++i)
+            {
+                fresh[i].value().~value_type();
+            }
+            delete[] fresh;
+            throw;
+        }
+        fresh[n].live = true;
+
+        destroy_values();
+        free_entries(entries_);
+        entries_ = fresh;
+        count_ = size_ = n;
+        capacity_ = capacity;
+        head_ = 0;
+        index_.swap(index);
+        shift_ = shift;
+        for (size_type i = 0; i < n; ++i)
+        {
+            place(entries_[i].hash, static_cast<Slot>(i));
+        }
+        if (positional_index_)
+        {
+            std::fill(counts.begin(), counts.begin() + n, 1);
+            sum_live_counts(counts);
+        }
+        live_counts_.swap(counts);
+    }
+
+}; // class dense_linked_hash_map
+
+} // namespace ppstd
+
+#endif // PPSTD_DENSE_LINKED_HASH_MAP_H_
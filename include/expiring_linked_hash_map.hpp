@@ -0,0 +1,262 @@
+/*
+ * expiring_linked_hash_map
+ *
+ * A ppstd::linked_hash_map whose elements expire ttl after their insertion.
+ * The deadline is stored next to each mapped value. With one ttl for all the
+ * elements, the insertion order is the order of the deadlines, so the stale
+ * elements are always a prefix of the order: expire(now, max_work) pops them
+ * off the front, and stops after max_work of them, without looking at any
+ * live element. A shorter ttl(d) keeps it so by cutting the deadlines already
+ * after now + d back to now + d.
+ *
+ * Each insert, and each visit, also expires up to piggyback() elements, so
+ * a steadily used map stays clean without a separate sweep. Stale elements
+ * not expired yet are never found, but they are counted by size().
+ *
+ * Clock is a std::chrono clock, or anything with time_point, duration and
+ * a static now(), e.g. a manual clock for the tests.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_EXPIRING_LINKED_HASH_MAP_H_
+#define PPSTD_EXPIRING_LINKED_HASH_MAP_H_
+
+#include <chrono>
+#include <iterator>
+
+#include "linked_hash_map.hpp"
+
+namespace ppstd
+{
+
+namespace detail
+{
+
+template <typename T, typename TimePoint>
+struct Expiring
+{
+    TimePoint deadline;
+    T value;
+
+    template <typename... Args>
+    explicit Expiring(TimePoint d, Args&&... args)
+        : deadline(d), value(std::forward<Args>(args)...) {}
+};
+
+} // namespace detail
+
+
+template <class Key, class T, class Clock = std::chrono::steady_clock,
+    class Hash = std::hash<Key>, class Pred = std::equal_to<Key>>
+class expiring_linked_hash_map
+{
+public:
+    using time_point = typename Clock::time_point;
+    using duration = typename Clock::duration;
+
+private:
+    using Map = linked_hash_map<Key, detail::Expiring<T, time_point>, Hash, Pred>;
+
+    // in the order of the deadlines, the oldest first
+    Map map_;
+    duration ttl_;
+    std::size_t piggyback_;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = size_t;
+
+    // a piggyback of 0 leaves all the expiring to expire()
+    explicit expiring_linked_hash_map(duration ttl, size_type piggyback = 2,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : map_(0, hf, eql), ttl_(ttl), piggyback_{ piggyback } {}
+
+
+    // including the stale elements not expired yet
+    size_type size() const noexcept { return map_.size(); }
+    bool empty() const noexcept { return map_.empty(); }
+
+    // a longer ttl applies to the elements inserted from then on; a shorter one
+    // also ends the present elements by now + d at the latest, or an old element
+    // would outlive the new ones behind it and hold back their expiry
+    duration ttl() const { return ttl_; }
+
+    void ttl(duration d)
+    {
+        if (d < ttl_)
+        {
+            // the deadlines are sorted, so only a suffix is after the new one
+            const time_point last = Clock::now() + d;
+            typename Map::iterator it = map_.end();
+            while (it != map_.begin() && last < std::prev(it)->second.deadline)
+            {
+                (--it)->second.deadline = last;
+            }
+        }
+        ttl_ = d;
+    }
+
+    size_type piggyback() const noexcept { return piggyback_; }
+    void piggyback(size_type n) noexcept { piggyback_ = n; }
+
+
+    bool insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+
+    // returns whether the key was inserted; a stale element of k counts as missing
+    // and is replaced, with a new deadline at the end of the order
+    template <class... Args>
+    bool try_emplace(const key_type& k, Args&&... args)
+    {
+        const time_point now = Clock::now();
+        expire(now, piggyback_);
+        std::pair<typename Map::iterator, bool> res =
+            map_.try_emplace(k, now + ttl_, std::forward<Args>(args)...);
+        if (res.second)
+        {
+            return true;
+        }
+        if (!stale(res.first, now))
+        {
+            return false;
+        }
+        // try_emplace left args alone on the hit
+        res.first->second.value = mapped_type(std::forward<Args>(args)...);
+        renew(res.first, now);
+        return true;
+    }
+
+    // an assigned element starts a new ttl, and moves to the end of the order
+    template <class M>
+    bool insert_or_assign(const key_type& k, M&& obj)
+    {
+        const time_point now = Clock::now();
+        expire(now, piggyback_);
+        std::pair<typename Map::iterator, bool> res =
+            map_.try_emplace(k, now + ttl_, std::forward<M>(obj));
+        if (!res.second)
+        {
+            const bool was_stale = stale(res.first, now);
+            res.first->second.value = std::forward<M>(obj);
+            renew(res.first, now);
+            return was_stale;
+        }
+        return true;
+    }
+
+    size_type erase(const key_type& k)
+    {
+        return map_.erase(k);
+    }
+
+    void clear() noexcept
+    {
+        map_.clear();
+    }
+
+    void reserve(size_type n)
+    {
+        map_.reserve(n);
+    }
+
+
+    // pops the elements whose deadline is not after now off the front of the order,
+    // at most max_work of them; returns how many
+    size_type expire(time_point now, size_type max_work = static_cast<size_type>(-1))
+    {
+        size_type n = 0;
+        for (; n < max_work && !map_.empty() && stale(map_.begin(), now); ++n)
+        {
+            map_.erase(map_.begin());
+        }
+        return n;
+    }
+
+    size_type expire() { return expire(Clock::now()); }
+
+    // the deadline of the oldest element, time_point::max() if there is none
+    time_point next_expiry() const
+    {
+        return map_.empty() ? time_point::max() : map_.begin()->second.deadline;
+    }
+
+
+    // copies the mapped value out, returns false if k is not there or stale
+    bool find(const key_type& k, mapped_type& out) const
+    {
+        typename Map::const_iterator it = map_.find(k);
+        if (it == map_.end() || stale(it, Clock::now()))
+        {
+            return false;
+        }
+        out = it->second.value;
+        return true;
+    }
+
+    bool contains(const key_type& k) const
+    {
+        typename Map::const_iterator it = map_.find(k);
+        return it != map_.end() && !stale(it, Clock::now());
+    }
+
+    size_type count(const key_type& k) const { return contains(k) ? 1 : 0; }
+
+    // calls fn(mapped_type&), returns false if k is not there or stale
+    template <class F>
+    bool visit(const key_type& k, F&& fn)
+    {
+        const time_point now = Clock::now();
+        expire(now, piggyback_);
+        typename Map::iterator it = map_.find(k);
+        if (it == map_.end() || stale(it, now))
+        {
+            return false;
+        }
+        fn(it->second.value);
+        return true;
+    }
+
+    // calls fn(const key_type&, const mapped_type&) for the live elements,
+    // the oldest first
+    template <class F>
+    void for_each(F&& fn) const
+    {
+        const time_point now = Clock::now();
+        typename Map::const_iterator it = map_.begin();
+        while (it != map_.end() && stale(it, now))
+        {
+            ++it;
+        }
+        for (; it != map_.end(); ++it)
+        {
+            fn(it->first, it->second.value);
+        }
+    }
+
+private:
+    template <class Iter>
+    static bool stale(const Iter& it, time_point now)
+    {
+        return !(now < it->second.deadline);
+    }
+
+    void renew(typename Map::iterator it, time_point now)
+    {
+        it->second.deadline = now + ttl_;
+        map_.move_to_back(it);
+    }
+
+}; // class expiring_linked_hash_map
+
+} // namespace ppstd
+
+#endif // PPSTD_EXPIRING_LINKED_HASH_MAP_H_
@@ -0,0 +1,297 @@
+/*
+ * frozen_linked_hash_map
+ *
+ * An immutable ppstd::linked_hash_map for lookup tables known at compile
+ * time, e.g. protocol opcodes to handlers in their order of declaration.
+ * It is built by a constexpr constructor, so a constexpr instance costs
+ * nothing at startup and lives in read-only data, without the heap.
+ *
+ * The elements are kept in an array in their given order. A perfect hash
+ * (hash and displace: each first-level bucket of keys gets the seed that
+ * puts all of its keys into free slots) is computed while building, so a
+ * lookup is one call of Hash, two table reads and one call of Pred.
+ *
+ * Hash and Pred must be constexpr; ppstd::frozen_hash covers the integral
+ * and enum keys, and std::string_view in C++ 17. Needs C++ 14.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_FROZEN_LINKED_HASH_MAP_H_
+#define PPSTD_FROZEN_LINKED_HASH_MAP_H_
+
+#if !(defined(_MSVC_LANG) && _MSVC_LANG >= 201402L || __cplusplus >= 201402L)
+#error "frozen_linked_hash_map.hpp needs C++ 14 for its constexpr construction"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSVC_LANG) && _MSVC_LANG >= 201703L || __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace ppstd
+{
+
+template <class Key, class = void>
+struct frozen_hash;
+
+template <class Key>
+struct frozen_hash<Key, typename std::enable_if<
+    std::is_integral<Key>::value || std::is_enum<Key>::value>::type>
+{
+    constexpr std::uint64_t operator()(Key k) const noexcept
+    {
+        return static_cast<std::uint64_t>(k);
+    }
+};
+
+#if defined(_MSVC_LANG) && _MSVC_LANG >= 201703L || __cplusplus >= 201703L
+// FNV-1a
+template <>
+struct frozen_hash<std::string_view>
+{
+    constexpr std::uint64_t operator()(std::string_view s) const noexcept
+    {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for (char c : s)
+        {
+            h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        return h;
+    }
+};
+#endif
+
+
+namespace detail
+{
+
+// the murmur3 finalizer, the hash values of Hash need not be well spread
+constexpr std::uint64_t frozen_mix(std::uint64_t x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// a power of two with at most half of the slots in use
+constexpr std::size_t frozen_table_size(std::size_t n) noexcept
+{
+    std::size_t count = 1;
+    while (count < 2 * n)
+    {
+        count <<= 1;
+    }
+    return count;
+}
+
+// the seeds tried for one bucket before two keys are taken for equal hash values
+constexpr std::uint32_t frozen_seed_limit() { return 1u << 16; }
+
+} // namespace detail
+
+
+template <class Key, class T, std::size_t N, class Hash = frozen_hash<Key>,
+    class Pred = std::equal_to<Key>>
+class frozen_linked_hash_map
+{
+    static_assert(N > 0, "frozen_linked_hash_map needs at least one element");
+    static_assert(N < (std::size_t(1) << 31), "frozen_linked_hash_map is limited to 2^31 elements");
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using reference = const value_type&;
+    using const_reference = const value_type&;
+    using pointer = const value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    // nothing can be changed, so both are pointers into the ordered array
+    using iterator = const value_type*;
+    using const_iterator = const value_type*;
+
+private:
+    static constexpr size_type table_size = detail::frozen_table_size(N);
+    // the slots of the second level, N for a free one
+    static constexpr std::uint32_t free_slot = static_cast<std::uint32_t>(N);
+
+    value_type entries_[N];
+    // the seed of each first-level bucket, then the entry of each slot
+    std::uint32_t seeds_[table_size];
+    std::uint32_t slots_[table_size];
+    Hash hash_;
+    Pred eq_;
+
+public:
+    // throws std::invalid_argument for duplicate keys, which fails a constexpr build
+    constexpr explicit frozen_linked_hash_map(const std::pair<Key, T> (&items)[N],
+        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : frozen_linked_hash_map(items, hf, eql, std::make_index_sequence<N>()) {}
+
+
+    constexpr bool empty() const noexcept { return false; }
+    constexpr size_type size() const noexcept { return N; }
+    constexpr size_type max_size() const noexcept { return N; }
+
+
+    constexpr const_iterator begin() const noexcept { return entries_; }
+    constexpr const_iterator end() const noexcept { return entries_ + N; }
+    constexpr const_iterator cbegin() const noexcept { return entries_; }
+    constexpr const_iterator cend() const noexcept { return entries_ + N; }
+
+
+    constexpr const_iterator find(const key_type& k) const { return entries_ + find_index(k); }
+
+    constexpr size_type count(const key_type& k) const { return find_index(k) != N ? 1 : 0; }
+
+    constexpr bool contains(const key_type& k) const { return find_index(k) != N; }
+
+    constexpr std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        const size_type i = find_index(k);
+        return std::pair<const_iterator, const_iterator>{entries_ + i, entries_ + (i != N ? i + 1 : N)};
+    }
+
+    constexpr const mapped_type& at(const key_type& k) const
+    {
+        const size_type i = find_index(k);
+        if (i == N)
+        {
+            throw std::out_of_range("frozen_linked_hash_map::at: key not found");
+        }
+        return entries_[i].second;
+    }
+
+
+    constexpr hasher hash_function() const { return hash_; }
+    constexpr key_equal key_eq() const { return eq_; }
+
+private:
+    template <std::size_t... I>
+    constexpr frozen_linked_hash_map(const std::pair<Key, T> (&items)[N],
+        const hasher& hf, const key_equal& eql, std::index_sequence<I...>)
+        : entries_{ value_type(items[I])... }, seeds_{}, slots_{}, hash_(hf), eq_(eql)
+    {
+        build();
+    }
+
+    static constexpr size_type bucket_of(std::uint64_t mixed) noexcept
+    {
+        return static_cast<size_type>(mixed >> 32) & (table_size - 1);
+    }
+
+    static constexpr size_type slot_of(std::uint64_t mixed, std::uint32_t seed) noexcept
+    {
+        return static_cast<size_type>(detail::frozen_mix(mixed + seed)) & (table_size - 1);
+    }
+
+    // N for a miss, which makes find() return end()
+    constexpr size_type find_index(const key_type& k) const
+    {
+        const std::uint64_t mixed = detail::frozen_mix(hash_(k));
+        const size_type i = slots_[slot_of(mixed, seeds_[bucket_of(mixed)])];
+        return i != N && eq_(entries_[i].first, k) ? i : N;
+    }
+
+    // the keys are grouped by bucket, and the largest buckets get their seeds first,
+    // while most slots are still free
+    constexpr void build()
+    {
+        std::uint64_t mixed[N] = {};
+        size_type start[table_size + 1] = {};
+        size_type members[N] = {};
+        size_type placed[table_size] = {};
+        size_type largest = 0;
+
+        for (size_type i = 0; i < N; ++i)
+        {
+            mixed[i] = detail::frozen_mix(hash_(entries_[i].first));
+            ++start[bucket_of(mixed[i]) + 1];
+        }
+        for (size_type b = 0; b < table_size; ++b)
+        {
+            largest = start[b + 1] > largest ? start[b + 1] : largest;
+            start[b + 1] += start[b];
+            slots_[b] = free_slot;
+        }
+        for (size_type i = 0; i < N; ++i)
+        {
+            const size_type b = bucket_of(mixed[i]);
+            members[start[b] + placed[b]++] = i;
+        }
+
+        for (size_type n = largest; n > 0; --n)
+        {
+            for (size_type b = 0; b < table_size; ++b)
+            {
+                if (start[b + 1] - start[b] == n)
+                {
+                    seeds_[b] = seed_bucket(mixed, members + start[b], n);
+                }
+            }
+        }
+    }
+
+    // the first seed that puts the n keys of a bucket into free slots, and places them
+    constexpr std::uint32_t seed_bucket(const std::uint64_t* mixed, const size_type* keys, size_type n)
+    {
+        for (size_type i = 0; i < n; ++i)
+        {
+            for (size_type j = i + 1; j < n; ++j)
+            {
+                if (eq_(entries_[keys[i]].first, entries_[keys[j]].first))
+                {
+                    throw std::invalid_argument("frozen_linked_hash_map: duplicate key");
+                }
+            }
+        }
+        for (std::uint32_t seed = 0; seed < detail::frozen_seed_limit(); ++seed)
+        {
+            size_type done = 0;
+            while (done < n && slots_[slot_of(mixed[keys[done]], seed)] == free_slot)
+            {
+                slots_[slot_of(mixed[keys[done]], seed)] = static_cast<std::uint32_t>(keys[done]);
+                ++done;
+            }
+            if (done == n)
+            {
+                return seed;
+            }
+            for (size_type i = 0; i < done; ++i)
+            {
+                slots_[slot_of(mixed[keys[i]], seed)] = free_slot;
+            }
+        }
+        throw std::invalid_argument("frozen_linked_hash_map: keys with equal hash values");
+    }
+
+}; // class frozen_linked_hash_map
+
+
+// the size is deduced: make_frozen_linked_hash_map<int, Handler>({ { 1, on_open }, { 2, on_close } })
+template <class Key, class T, class Hash = frozen_hash<Key>, class Pred = std::equal_to<Key>, std::size_t N>
+constexpr frozen_linked_hash_map<Key, T, N, Hash, Pred> make_frozen_linked_hash_map(
+    const std::pair<Key, T> (&items)[N], const Hash& hf = Hash(), const Pred& eql = Pred())
+{
+    return frozen_linked_hash_map<Key, T, N, Hash, Pred>(items, hf, eql);
+}
+
+} // namespace ppstd
+
+#endif // PPSTD_FROZEN_LINKED_HASH_MAP_H_
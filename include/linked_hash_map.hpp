@@ -10,96 +10,148 @@
  * This file is licensed under the MIT license.
  * Some codes are modified from those in LLVM's libc++.
  *
+ * Define PPSTD_LINKED_HASH_MAP_STATS before including it to make every map
+ * count its hash calls, probes, rehashes and node allocations, see stats().
+ *
  */
 
 
 #ifndef PPSTD_LINKED_HASH_MAP_H_
 #define PPSTD_LINKED_HASH_MAP_H_
 
+#include <algorithm>
 #include <cassert>
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+#include <chrono>
+#endif
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
-#include <list>
-#include <memory>
-#include <type_traits>
-#include <unordered_map>
-#include <iostream>
-
-#if defined(_MSC_VER) && _MSC_VER < 1800 || !defined(_MSC_VER) && __cplusplus < 201402L
-// https://isocpp.org/files/papers/N3656.txt
-#include <cstddef>
 #include <memory>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <utility>
-namespace std {
-    template<class T> struct _Unique_if {
-        typedef unique_ptr<T> _Single_object;
-    };
-    template<class T> struct _Unique_if<T[]> {
-        typedef unique_ptr<T[]> _Unknown_bound;
-    };
-    template<class T, size_t N> struct _Unique_if<T[N]> {
-        typedef void _Known_bound;
-    };
-    template<class T, class... Args>
-    typename _Unique_if<T>::_Single_object
-        make_unique(Args&&... args) {
-        return unique_ptr<T>(new T(std::forward<Args>(args)...));
-    }
-    template<class T>
-    typename _Unique_if<T>::_Unknown_bound
-        make_unique(size_t n) {
-        typedef typename remove_extent<T>::type U;
-        return unique_ptr<T>(new U[n]());
-    }
-    template<class T, class... Args>
-    typename _Unique_if<T>::_Known_bound
-        make_unique(Args&&...) = delete;
-}
-#endif // __cplusplus < 201402L 
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
 
 
 namespace ppstd
 {
 
+template <class Key, class T, class Hash, class Pred, class Alloc>
+class linked_hash_map;
+
 namespace detail
 {
 
-template <typename K, typename V>
-struct BackMapped
+// the prev/next links of the insertion order list,
+// the list is circular and the container holds one sentinel as end()
+struct ListLinks
 {
+    ListLinks* prev;
+    ListLinks* next;
+};
+
+// one allocation per element:
+// order links, the links of the bucket chain, and the value itself.
+// pchain points at whatever points at this node, the bucket slot or
+// the chain of the previous node, so a node unlinks itself without hashing
+template <typename V>
+struct Node : ListLinks
+{
+    using value_type = V;
+
+    Node* chain;
+    Node** pchain;
     V value;
-    K* ptr_key;
-    BackMapped(const V& v = V{}, K* pk = nullptr) : value{ v }, ptr_key{ pk } {}
-    BackMapped(V&& v = V{}, K* pk = nullptr) : value{ v }, ptr_key{ pk } {}
+
+    template <typename... Args>
+    explicit Node(Args&&... args)
+        : ListLinks{ nullptr, nullptr }, chain{ nullptr }, pchain{ nullptr },
+        value(std::forward<Args>(args)...) {}
+};
+
+// a node that also stores the full hash value of its key
+template <typename V>
+struct HashedNode : Node<V>
+{
+    std::size_t hash;
+
+    template <typename... Args>
+    explicit HashedNode(Args&&... args) : Node<V>(std::forward<Args>(args)...), hash{ 0 } {}
+};
+
+// the mapped type of the nodes of linked_hash_set, which hold the key alone
+struct KeyOnly {};
+
+// what a node holds: the key value pair, or only the key for KeyOnly
+template <typename Key, typename T>
+struct NodeElement
+{
+    using type = std::pair<const Key, T>;
+
+    static const Key& key(const type& v) noexcept { return v.first; }
+};
+
+template <typename Key>
+struct NodeElement<Key, KeyOnly>
+{
+    using type = const Key;
+
+    static const Key& key(const Key& v) noexcept { return v; }
 };
 
-template <typename K, typename V>
+template <typename K, typename V, typename Element = std::pair<K, typename std::remove_const<V>::type>>
 class Iterator
 {
 private:
-    using List = typename std::conditional<
+    using NodeType = Node<Element>;
+    using Links = typename std::conditional<
+        std::is_const<V>::value,
+        const ListLinks,
+        ListLinks
+        >::type;
+    using Value = typename std::conditional<
         std::is_const<V>::value,
-        const std::list< detail::BackMapped< K, typename std::remove_const<V>::type > >,
-        std::list< detail::BackMapped<K, V> >
+        const NodeType,
+        NodeType
         >::type;
-    using ListIterator = typename std::conditional<
+    using Pair = typename std::conditional<
         std::is_const<V>::value,
-        typename List::const_iterator,
-        typename List::iterator
+        const Element,
+        Element
         >::type;
-        
-    List* ptr_back_list_;
-    ListIterator iter_back_list_;
+
+    template <typename, typename, typename> friend class Iterator;
+    template <class, class, class, class, class> friend class ppstd::linked_hash_map;
+
+    Links* node_;
+
+    Value* node() const { return static_cast<Value*>(node_); }
 
 public:
     using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename std::remove_const<Element>::type;
+    using difference_type = std::ptrdiff_t;
+    using reference = Pair&;
+    using pointer = Pair*;
 
-    Iterator(List* const pbl = nullptr, const ListIterator& ibl = ListIterator{})
-        : ptr_back_list_{ pbl }, iter_back_list_{ ibl } {}
+    explicit Iterator(Links* const node = nullptr) : node_{ node } {}
 
-    Iterator(const Iterator& rhs)
-        : ptr_back_list_{ rhs.ptr_back_list_ }, iter_back_list_{ rhs.iter_back_list_ } {}
+    Iterator(const Iterator& rhs) : node_{ rhs.node_ } {}
+
+    // iterator -> const_iterator
+    template <typename U, typename = typename std::enable_if<
+        std::is_const<V>::value && std::is_same<U, typename std::remove_const<V>::type>::value>::type>
+    Iterator(const Iterator<K, U, Element>& rhs) : node_{ rhs.node_ } {}
 
     Iterator(Iterator&& rhs) : Iterator()
     {
@@ -116,7 +168,7 @@ public:
 
     Iterator& operator++()
     {
-        ++iter_back_list_;
+        node_ = node_->next;
         return *this;
     }
 
@@ -129,7 +181,7 @@ public:
 
     Iterator& operator--()
     {
-        --iter_back_list_;
+        node_ = node_->prev;
         return *this;
     }
 
@@ -140,28 +192,19 @@ public:
         return orig;
     }
 
-    std::pair<K&, V&> operator*()
-    {
-        return std::make_pair(std::ref(*(iter_back_list_->ptr_key)), std::ref(iter_back_list_->value));
-    }
-
-    std::unique_ptr<std::pair<K&, V&>> operator->()
-    {
-        return std::make_unique<std::pair<K&, V&>>(
-            *(iter_back_list_->ptr_key), iter_back_list_->value);
-    }
+    // the pair lives in the node, so both are plain references
+    reference operator*() const { return node()->value; }
+    pointer operator->() const { return &node()->value; }
 
     void swap(Iterator& rhs)
     {
         using std::swap;
-        swap(ptr_back_list_, rhs.ptr_back_list_);
-        swap(iter_back_list_, rhs.iter_back_list_);
+        swap(node_, rhs.node_);
     }
 
     friend bool operator==(const Iterator& lhs, const Iterator& rhs)
     {
-        return lhs.ptr_back_list_ == rhs.ptr_back_list_ &&
-            lhs.iter_back_list_ == rhs.iter_back_list_;
+        return lhs.node_ == rhs.node_;
     }
 
     friend bool operator!=(const Iterator& lhs, const Iterator& rhs)
@@ -175,328 +218,2510 @@ public:
     }
 }; // class Iterator
 
-} // namespace detail
-
-
-template <class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>>
-class linked_hash_map
+// the node_type of the maps, owns one extracted node,
+// which goes into another map without allocating or copying
+template <typename NodeT, typename NodeAlloc>
+class NodeHandle
 {
 private:
-    using BackList = std::list<detail::BackMapped<const Key, T>>;
-    using BackListIterator = typename BackList::iterator;
-    using BackListConstIterator = typename BackList::const_iterator;
-    BackList back_list_;
-    using BackMap = std::unordered_map<Key, BackListIterator, Hash, Pred>;
-    using BackMapIterator = typename BackMap::iterator;
-    using BackMapConstIterator = typename BackMap::const_iterator;
-    BackMap back_map_;
+    using AllocTraits = std::allocator_traits<NodeAlloc>;
+    using Value = typename NodeT::value_type;
 
-public:
-    using key_type = Key;
-    using mapped_type = T;
-    using hasher = Hash;
-    using key_equal = Pred;
-    using value_type = std::pair<const key_type, mapped_type>;
-    using reference = value_type&;
-    using const_reference = const value_type&;
-    using pointer = value_type*;
-    using const_pointer = const value_type*;
-    using size_type = size_t;
-    using difference_type = std::ptrdiff_t;
+    template <class, class, class, class, class> friend class ppstd::linked_hash_map;
 
-    using iterator = detail::Iterator<const key_type, mapped_type>;
-    using const_iterator = detail::Iterator<const key_type, const mapped_type>;
+    NodeT* node_;
+    // only alive while node_ is set, as the std::optional of the std node handles
+    typename std::aligned_storage<sizeof(NodeAlloc), alignof(NodeAlloc)>::type alloc_;
 
+    NodeAlloc& alloc() noexcept { return *reinterpret_cast<NodeAlloc*>(&alloc_); }
+    const NodeAlloc& alloc() const noexcept { return *reinterpret_cast<const NodeAlloc*>(&alloc_); }
 
-    linked_hash_map()
-        noexcept(
-            std::is_nothrow_default_constructible<hasher>::value &&
-            std::is_nothrow_default_constructible<key_equal>::value) {}
+    NodeHandle(NodeT* node, const NodeAlloc& a) : node_{ node }
+    {
+        ::new (static_cast<void*>(&alloc_)) NodeAlloc(a);
+    }
 
-    explicit linked_hash_map(size_type n, const hasher& hf = hasher(),
-        const key_equal& eql = key_equal()) : back_map_(n, hf, eql) {}
+    NodeT* release() noexcept
+    {
+        NodeT* node = node_;
+        alloc().~NodeAlloc();
+        node_ = nullptr;
+        return node;
+    }
 
-    template <class InputIterator>
-    linked_hash_map(InputIterator first, InputIterator last,
-        size_type n = 0, const hasher& hf = hasher(),
-        const key_equal& eql = key_equal()) : linked_hash_map(n, hf, eql)
+    void reset() noexcept
     {
-        insert(first, last);
+        if (node_ != nullptr)
+        {
+            AllocTraits::destroy(alloc(), node_);
+            AllocTraits::deallocate(alloc(), node_, 1);
+            release();
+        }
     }
 
-    linked_hash_map(const linked_hash_map& rhs) : linked_hash_map()
+public:
+    using key_type = typename std::remove_const<typename Value::first_type>::type;
+    using mapped_type = typename Value::second_type;
+    using allocator_type = typename AllocTraits::template rebind_alloc<
+        std::pair<const key_type, mapped_type>>;
+
+    NodeHandle() noexcept : node_{ nullptr } {}
+
+    NodeHandle(NodeHandle&& rhs) noexcept : node_{ nullptr }
     {
-        insert(rhs.begin(), rhs.end());
+        if (rhs.node_ != nullptr)
+        {
+            ::new (static_cast<void*>(&alloc_)) NodeAlloc(std::move(rhs.alloc()));
+            node_ = rhs.release();
+        }
     }
 
-    linked_hash_map(linked_hash_map&& rhs)
-        noexcept(
-            std::is_nothrow_move_constructible<hasher>::value &&
-            std::is_nothrow_move_constructible<key_equal>::value) : linked_hash_map()
+    NodeHandle& operator=(NodeHandle&& rhs) noexcept
     {
-        swap(rhs);
+        if (this != &rhs)
+        {
+            reset();
+            if (rhs.node_ != nullptr)
+            {
+                ::new (static_cast<void*>(&alloc_)) NodeAlloc(std::move(rhs.alloc()));
+                node_ = rhs.release();
+            }
+        }
+        return *this;
     }
 
-    linked_hash_map(std::initializer_list<value_type> ilist, size_type n = 0,
-        const hasher& hf = hasher(), const key_equal& eql = key_equal())
-        : linked_hash_map(n, hf, eql)
+    ~NodeHandle() { reset(); }
+
+    bool empty() const noexcept { return node_ == nullptr; }
+    explicit operator bool() const noexcept { return node_ != nullptr; }
+
+    // a changed key is hashed again when the node is inserted
+    key_type& key() const { return const_cast<key_type&>(node_->value.first); }
+    mapped_type& mapped() const { return node_->value.second; }
+    allocator_type get_allocator() const { return allocator_type(alloc()); }
+
+    void swap(NodeHandle& rhs) noexcept
     {
-        insert(ilist.begin(), ilist.end());
+        NodeHandle tmp(std::move(rhs));
+        rhs = std::move(*this);
+        *this = std::move(tmp);
     }
 
-    linked_hash_map(size_type n) : linked_hash_map(n, hasher(), key_equal()) {}
+    friend void swap(NodeHandle& lhs, NodeHandle& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+}; // class NodeHandle
 
-    linked_hash_map(size_type n, const hasher& hf) : linked_hash_map(n, hf, key_equal()) {}
+template <typename Iter, typename NodeType>
+struct InsertReturnType
+{
+    Iter position;
+    bool inserted;
+    NodeType node;
+};
 
-    template <class InputIterator>
-    linked_hash_map(InputIterator f, InputIterator l, size_type n)
-        : linked_hash_map(f, l, n, hasher(), key_equal()) {}
+template <typename P, typename K>
+struct is_pair_of_key : std::false_type {};
 
-    template <class InputIterator>
-    linked_hash_map(InputIterator f, InputIterator l, size_type n, const hasher& hf)
-        : linked_hash_map(f, l, n, hf, key_equal()) {}
+template <typename A, typename B, typename K>
+struct is_pair_of_key<std::pair<A, B>, K>
+    : std::is_same<typename std::remove_const<A>::type, K> {};
 
-    linked_hash_map(std::initializer_list<value_type> il, size_type n)
-        : linked_hash_map(il, n, hasher(), key_equal()) {}
+// fibonacci hashing spreads the user's hash values over
+// the power-of-two bucket array, even for the identity std::hash<int>
+constexpr std::size_t hash_multiplier()
+{
+    return sizeof(std::size_t) >= 8 ?
+        static_cast<std::size_t>(0x9E3779B97F4A7C15ull) :
+        static_cast<std::size_t>(0x9E3779B9ul);
+}
 
-    linked_hash_map(std::initializer_list<value_type> il, size_type n, const hasher& hf)
-        : linked_hash_map(il, n, hf, key_equal()) {}
+constexpr std::size_t min_bucket_count() { return 8; }
 
-    ~linked_hash_map() {}
+// the old buckets moved by each insert during an incremental rehash; a pass
+// ends before the next growth as long as max_load_factor() >= 1 / rehash_step()
+constexpr std::size_t rehash_step() { return 8; }
 
-    linked_hash_map& operator=(linked_hash_map rhs)
-    {
-        swap(rhs);
-        return *this;
-    }
+// a hint only, the address may be anything including invalid
+inline void prefetch(const void* p) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
 
-    linked_hash_map& operator=(linked_hash_map&& rhs)
-    {
-        swap(rhs);
-        return *this;
-    }
+constexpr std::size_t bulk_batch_size() { return 16; }
 
-    linked_hash_map& operator=(std::initializer_list<value_type> ilist)
+// the murmur3 finalizer; the key fingerprints add up the mixed hash values,
+// so they need more than the raw ones, which may be the identity
+inline std::uint64_t fingerprint_mix(std::uint64_t x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// reads and writes the nodes for linked_hash_map_snapshot.hpp
+template <class Map>
+struct SnapshotAccess;
+
+template <class...>
+struct make_void
+{
+    using type = void;
+};
+
+template <class T, class = void>
+struct is_transparent : std::false_type {};
+
+template <class T>
+struct is_transparent<T, typename make_void<typename T::is_transparent>::type> : std::true_type {};
+
+// find(const K&) etc. are enabled when both functors accept any comparable key,
+// as with the C++ 20 unordered containers
+template <class Hash, class Pred>
+struct is_transparent_lookup : std::integral_constant<bool,
+    is_transparent<Hash>::value && is_transparent<Pred>::value> {};
+
+// the order-statistic tree of positional_index(true): an implicit treap with one
+// tree node per element, in the order of the list, so the subtree sizes give the
+// positions. The tree nodes live in one array and are found by the address of the
+// links of their element in an open-addressing table, so the nodes of the map carry
+// nothing for it. After reserve(size() + 1), insert_before(), erase() and rename()
+// neither allocate nor throw
+template <class Alloc>
+class PositionTree
+{
+private:
+    using Index = std::uint32_t;
+
+    struct Rank
     {
-        insert(ilist.begin(), ilist.end());
-        return *this;
-    }
+        const ListLinks* links;
+        Index left;
+        Index right;
+        Index parent;
+        Index size;
+        Index priority;
+    };
 
+    using RankAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Rank>;
+    using SlotAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Index>;
+    using Slots = std::vector<Index, SlotAlloc>;
 
-    bool empty() const noexcept { return back_map_.empty(); }
-    size_type size() const noexcept { return back_map_.size(); }
-    size_type max_size() const noexcept { return back_map_.max_size(); }
+    static constexpr Index nil() { return static_cast<Index>(-1); }
 
+    // the live tree nodes and the free ones, which are chained through parent
+    std::vector<Rank, RankAlloc> ranks_;
+    // indices into ranks_, nil() for an empty slot; a power of two, at most half full
+    Slots slots_;
+    std::size_t shift_;
+    std::size_t size_;
+    Index root_;
+    Index free_;
+    Index seed_;
 
-    iterator begin() noexcept { return iterator(&back_list_, back_list_.begin()); }
-    iterator end() noexcept { return iterator(&back_list_, back_list_.end()); }
-    const_iterator begin() const noexcept { return const_iterator(&back_list_, back_list_.begin()); }
-    const_iterator end() const noexcept { return const_iterator(&back_list_, back_list_.end()); }
-    const_iterator cbegin() const noexcept { return const_iterator(&back_list_, back_list_.cbegin()); }
-    const_iterator cend() const noexcept { return const_iterator(&back_list_, back_list_.cend()); }
+public:
+    explicit PositionTree(const Alloc& a)
+        : ranks_(RankAlloc(a)), slots_(SlotAlloc(a)), shift_{ 0 }, size_{ 0 },
+        root_{ nil() }, free_{ nil() }, seed_{ 0x9E3779B9u } {}
 
+    std::size_t size() const noexcept { return size_; }
 
-    template <class... Args>
-    std::pair<iterator, bool> emplace(Args&&... args)
+    std::size_t memory() const noexcept
     {
-        return insert(std::move(value_type{ std::forward<Args>(args)... }));
+        return ranks_.capacity() * sizeof(Rank) + slots_.capacity() * sizeof(Index);
     }
 
-    template <class... Args>
-    iterator emplace_hint(const_iterator position, Args&&... args)
+    // room for n elements
+    void reserve(std::size_t n)
+    {
+        if (n >= nil())
+        {
+            throw std::length_error("linked_hash_map::positional_index: too many elements");
+        }
+        if (ranks_.capacity() < n)
+        {
+            ranks_.reserve(std::max(n, ranks_.capacity() * 2));
+        }
+        if (slots_.size() < 2 * n)
+        {
+            std::size_t count = std::max<std::size_t>(slots_.size() * 2, 16);
+            while (count < 2 * n)
+            {
+                count <<= 1;
+            }
+            std::size_t shift = sizeof(std::size_t) * CHAR_BIT;
+            for (std::size_t c = count; c > 1; c >>= 1)
+            {
+                --shift;
+            }
+            Slots fresh(count, nil(), slots_.get_allocator());
+            slots_.swap(fresh);
+            shift_ = shift;
+            for (Index i = 0; i < ranks_.size(); ++i)
+            {
+                if (ranks_[i].links != nullptr)
+                {
+                    insert_slot(i);
+                }
+            }
+        }
+    }
+
+    void clear() noexcept
     {
-        // a simplified version for this api, because we always insert it to the last
-        // maybe should compare the key value and get rejected if equal early
-        return emplace(std::forward<Args>(args)...).first;
+        ranks_.clear();
+        std::fill(slots_.begin(), slots_.end(), nil());
+        size_ = 0;
+        root_ = free_ = nil();
     }
 
-    std::pair<iterator, bool> insert(const value_type& value)
+    // the elements of the list of header, in their order
+    void build(const ListLinks* header)
     {
-        if (back_map_.count(value.first) == 0)
+        clear();
+        std::size_t n = 0;
+        for (const ListLinks* p = header->next; p != header; p = p->next)
         {
-            detail::BackMapped<const key_type, mapped_type> v{ value.second };
-            back_list_.push_back(std::move(v));
-            BackListIterator it = --back_list_.end();
-            std::pair<BackMapIterator, bool> back_res = back_map_.insert({ value.first, it });
-            it->ptr_key = &((back_res.first)->first);
-            return std::pair<iterator, bool>{iterator(&back_list_, it), true};
+            ++n;
         }
-        else
+        reserve(n);
+        for (const ListLinks* p = header->next; p != header; p = p->next)
         {
-            BackListIterator it = back_map_.find(value.first)->second;
-            return std::pair<iterator, bool>{iterator(&back_list_, it), false};
+            insert_before(p, nullptr);
         }
     }
 
-    template <class InputIterator>
-    void insert(InputIterator first, InputIterator last)
+    // links goes in front of before, a null before is the end
+    void insert_before(const ListLinks* links, const ListLinks* before) noexcept
     {
-        for (; first != last; ++first)
+        const Index x = allocate_rank(links);
+        insert_slot(x);
+        ++size_;
+        if (root_ == nil())
         {
-            insert(*first);
+            root_ = x;
+            return;
+        }
+        Index at;
+        if (before == nullptr)
+        {
+            at = rightmost(root_);
+            ranks_[at].right = x;
+        }
+        else
+        {
+            at = find(before);
+            if (ranks_[at].left == nil())
+            {
+                ranks_[at].left = x;
+            }
+            else
+            {
+                at = rightmost(ranks_[at].left);
+                ranks_[at].right = x;
+            }
+        }
+        ranks_[x].parent = at;
+        for (Index p = at; p != nil(); p = ranks_[p].parent)
+        {
+            ++ranks_[p].size;
+        }
+        while (ranks_[x].parent != nil() && ranks_[ranks_[x].parent].priority < ranks_[x].priority)
+        {
+            rotate_up(x);
         }
     }
 
-    void insert(std::initializer_list<value_type> ilist)
+    void erase(const ListLinks* links) noexcept
     {
-        insert(ilist.begin(), ilist.end());
+        const std::size_t slot = find_slot(links);
+        const Index x = slots_[slot];
+        erase_slot(slot);
+        // rotated down until it has at most one child, which takes its place
+        while (ranks_[x].left != nil() && ranks_[x].right != nil())
+        {
+            const Index l = ranks_[x].left;
+            const Index r = ranks_[x].right;
+            rotate_up(ranks_[l].priority > ranks_[r].priority ? l : r);
+        }
+        const Index child = ranks_[x].left != nil() ? ranks_[x].left : ranks_[x].right;
+        Index p = ranks_[x].parent;
+        if (child != nil())
+        {
+            ranks_[child].parent = p;
+        }
+        replace_child(p, x, child);
+        for (; p != nil(); p = ranks_[p].parent)
+        {
+            --ranks_[p].size;
+        }
+        ranks_[x].links = nullptr;
+        ranks_[x].parent = free_;
+        free_ = x;
+        --size_;
     }
 
+    // the element moved to other links, e.g. by compact()
+    void rename(const ListLinks* from, const ListLinks* to) noexcept
+    {
+        const std::size_t slot = find_slot(from);
+        const Index x = slots_[slot];
+        erase_slot(slot);
+        ranks_[x].links = to;
+        insert_slot(x);
+    }
 
-    hasher hash_function() const { return back_map_.hash_function(); }
-    key_equal key_eq() const { return back_map_.key_eq(); }
-
-
-    iterator erase(const_iterator position)
+    // i must be below size()
+    const ListLinks* nth(std::size_t i) const noexcept
     {
-        iterator res = find(position->first);
-        return erase(res);
+        Index x = root_;
+        for (;;)
+        {
+            const std::size_t left = size_of(ranks_[x].left);
+            if (i < left)
+            {
+                x = ranks_[x].left;
+            }
+            else if (i == left)
+            {
+                return ranks_[x].links;
+            }
+            else
+            {
+                i -= left + 1;
+                x = ranks_[x].right;
+            }
+        }
     }
 
-    iterator erase(iterator position)
+    std::size_t rank(const ListLinks* links) const noexcept
     {
-        // very inefficient in this implement
-        iterator res{ position };
-        ++res;
-        const key_type k = position->first;
-        back_list_.erase(back_map_.at(k));
-        back_map_.erase(k);
+        Index x = find(links);
+        std::size_t res = size_of(ranks_[x].left);
+        for (Index p = ranks_[x].parent; p != nil(); x = p, p = ranks_[p].parent)
+        {
+            if (ranks_[p].right == x)
+            {
+                res += size_of(ranks_[p].left) + 1;
+            }
+        }
         return res;
     }
 
-    size_type erase(const key_type& k)
+private:
+    std::size_t size_of(Index x) const noexcept { return x == nil() ? 0 : ranks_[x].size; }
+
+    Index rightmost(Index x) const noexcept
     {
-        if (count(k) == 0)
+        while (ranks_[x].right != nil())
         {
-            return 0;
+            x = ranks_[x].right;
         }
-        erase(find(k));
-        return 1;
+        return x;
     }
 
-    iterator erase(const_iterator first, const_iterator last)
+    void replace_child(Index parent, Index old, Index child) noexcept
     {
-        iterator res;
-        for (; first != last; ++first)
+        if (parent == nil())
         {
-            res = erase(first);
+            root_ = child;
+        }
+        else if (ranks_[parent].left == old)
+        {
+            ranks_[parent].left = child;
+        }
+        else
+        {
+            ranks_[parent].right = child;
         }
-        assert(res->first == last->first || "the range for erase() is invalid");
-        return res;
     }
 
-    void clear() noexcept { back_map_.clear(); back_list_.clear(); }
-
-
-    void swap(linked_hash_map& rhs) noexcept
+    // x takes the place of its parent, which becomes its child
+    void rotate_up(Index x) noexcept
     {
-        using std::swap;
-        swap(back_list_, rhs.back_list_);
-        swap(back_map_, rhs.back_map_);
+        const Index p = ranks_[x].parent;
+        Index moved;
+        if (ranks_[p].left == x)
+        {
+            moved = ranks_[x].right;
+            ranks_[p].left = moved;
+            ranks_[x].right = p;
+        }
+        else
+        {
+            moved = ranks_[x].left;
+            ranks_[p].right = moved;
+            ranks_[x].left = p;
+        }
+        if (moved != nil())
+        {
+            ranks_[moved].parent = p;
+        }
+        const Index g = ranks_[p].parent;
+        replace_child(g, p, x);
+        ranks_[x].parent = g;
+        ranks_[p].parent = x;
+        ranks_[x].size = ranks_[p].size;
+        ranks_[p].size = static_cast<Index>(1 + size_of(ranks_[p].left) + size_of(ranks_[p].right));
     }
 
-
-    iterator find(const key_type& k)
+    Index allocate_rank(const ListLinks* links) noexcept
     {
-        BackMapIterator map_it = back_map_.find(k);
-        return map_it == back_map_.end() ?
-            iterator(&back_list_, back_list_.end()) :
-            iterator(&back_list_, map_it->second);
+        // xorshift32 for the priorities
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        Index x = free_;
+        if (x != nil())
+        {
+            free_ = ranks_[x].parent;
+        }
+        else
+        {
+            // reserve() made room
+            x = static_cast<Index>(ranks_.size());
+            ranks_.emplace_back();
+        }
+        ranks_[x] = Rank{ links, nil(), nil(), nil(), 1, seed_ };
+        return x;
     }
 
-    const_iterator find(const key_type& k) const
+    std::size_t home(const ListLinks* links) const noexcept
     {
-        BackMapConstIterator map_it = back_map_.find(k);
-        return map_it == back_map_.end() ?
-            const_iterator(&back_list_, back_list_.end()) :
-            const_iterator(&back_list_, map_it->second);
+        return (static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(links)) * hash_multiplier()) >> shift_;
     }
 
-    size_type count(const key_type& k) const { return back_map_.count(k); }
-
-    std::pair<iterator, iterator> equal_range(const key_type& k)
+    std::size_t find_slot(const ListLinks* links) const noexcept
     {
-        iterator lower_it = find(k);
-        iterator upper_it = lower_it;
-        if (upper_it != end())
+        const std::size_t mask = slots_.size() - 1;
+        std::size_t i = home(links);
+        while (ranks_[slots_[i]].links != links)
         {
-            ++upper_it;
+            i = (i + 1) & mask;
         }
-        return std::pair<iterator, iterator>{std::move(lower_it), std::move(upper_it)};
+        return i;
     }
 
+    Index find(const ListLinks* links) const noexcept { return slots_[find_slot(links)]; }
 
-    mapped_type& operator[](const key_type& k)
+    void insert_slot(Index x) noexcept
     {
-        try
+        const std::size_t mask = slots_.size() - 1;
+        std::size_t i = home(ranks_[x].links);
+        while (slots_[i] != nil())
         {
-            return back_map_.at(k)->value;
-        }
-        catch (const std::out_of_range&)
-        {
-            return insert({ k, T{} }).first->second;
+            i = (i + 1) & mask;
         }
+        slots_[i] = x;
     }
 
-    mapped_type& operator[](key_type&& k)
+    // the backward shift deletion of linear probing, which leaves no tombstones
+    void erase_slot(std::size_t i) noexcept
     {
-        try
+        const std::size_t mask = slots_.size() - 1;
+        slots_[i] = nil();
+        for (std::size_t j = (i + 1) & mask; slots_[j] != nil(); j = (j + 1) & mask)
         {
-            return back_map_.at(k)->value;
-        }
-        catch (const std::out_of_range&)
-        {
-            return insert({ k, T{} }).first->second;
+            const std::size_t k = home(ranks_[slots_[j]].links);
+            // the entry at j stays unless its home is cyclically outside (i, j]
+            if (((j - k) & mask) >= ((j - i) & mask))
+            {
+                slots_[i] = slots_[j];
+                slots_[j] = nil();
+                i = j;
+            }
         }
     }
+}; // class PositionTree
 
-
-    mapped_type& at(const key_type& k) { return back_map_.at(k)->value; }
-    const mapped_type& at(const key_type& k) const { return back_map_.at(k)->value; }
+} // namespace detail
 
 
-    size_type bucket_count() const noexcept { return back_map_.bucket_count(); }
-    size_type max_bucket_count() const noexcept { return back_map_.max_bucket_count(); }
+// whether the nodes of linked_hash_map<Key, T, Hash, ...> store the full hash
+// value of their keys, so that rehash never calls Hash again and lookups compare
+// the hash values before the keys. By default only the keys of scalar types,
+// whose hash is cheap, are not cached. Specialize it for your own types.
+template <class Key, class Hash>
+struct cache_hash_code : std::integral_constant<bool, !std::is_scalar<Key>::value> {};
 
 
-    size_type bucket_size(size_type n) const { return back_map_.bucket_size(n); }
-    size_type bucket(const key_type& k) const { return back_map_.bucket(k); }
+// the counters of one map. They stay zero unless PPSTD_LINKED_HASH_MAP_STATS
+// is defined, and then they cost nothing
+struct linked_hash_map_stats
+{
+    std::size_t hash_calls;
+    // walks of a bucket chain, and the nodes visited by them
+    std::size_t lookups;
+    std::size_t probes;
+    std::size_t longest_probe;
+    std::size_t rehashes;
+    std::uint64_t rehash_nanoseconds;
+    std::size_t node_allocations;
+    std::size_t node_frees;
+    // at() throwing std::out_of_range, and new nodes dropped because growing threw
+    std::size_t at_misses;
+    std::size_t insert_rollbacks;
+};
 
 
-    float load_factor() const noexcept { return back_map_.load_factor(); }
-    float max_load_factor() const noexcept { return back_map_.max_load_factor(); }
-    void max_load_factor(float z) { return back_map_.max_load_factor(z); }
-    void rehash(size_type n) { return back_map_.rehash(n); }
-    void reserve(size_type n) { return back_map_.reserve(n); }
+// the bytes a map has allocated, as reported by memory_usage(); the bookkeeping
+// of the allocator and the heap memory owned by the keys and values are not known
+struct linked_hash_map_memory
+{
+    // the bucket array (two of them during an incremental rehash) and the positional
+    // index, or the index and the positional index of dense_linked_hash_map
+    std::size_t buckets;
+    // what each element costs beyond its key value pair: the order and chain
+    // links, the cached hash value and the padding
+    std::size_t node_overhead;
+    // sizeof(value_type) per element
+    std::size_t payload;
+    // allocated but holding no element: nodes a compact() pass still has to free,
+    // or the unused entries and tombstones of dense_linked_hash_map
+    std::size_t spare;
+
+    std::size_t total() const noexcept { return buckets + node_overhead + payload + spare; }
+};
 
 
-    friend bool operator==(linked_hash_map& lhs, linked_hash_map& rhs)
-    {
-        if (lhs.size() != rhs.size())
-        {
-            return false;
-        }
+template <class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>,
+    class Alloc = std::allocator<std::pair<const Key, T>>>
+class linked_hash_map
+{
+private:
+    using CacheHash = std::integral_constant<bool, cache_hash_code<Key, Hash>::value>;
+    // the nodes of linked_hash_set hold only the key
+    using IsSet = std::is_same<T, detail::KeyOnly>;
+    using Element = typename detail::NodeElement<Key, T>::type;
+    // the chains link the nodes as NodeBase, Node is what is allocated
+    using NodeBase = detail::Node<Element>;
+    using Node = typename std::conditional<CacheHash::value,
+        detail::HashedNode<Element>, NodeBase>::type;
+    using Links = detail::ListLinks;
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using NodeAlloc = typename AllocTraits::template rebind_alloc<Node>;
+    using NodeAllocTraits = std::allocator_traits<NodeAlloc>;
+    using BucketAlloc = typename AllocTraits::template rebind_alloc<NodeBase*>;
+    using Buckets = std::vector<NodeBase*, BucketAlloc>;
+    using Positions = detail::PositionTree<Alloc>;
+
+    // sentinel of the order list, header_.next is the oldest element
+    Links header_;
+    // heads of the bucket chains, the size is zero or a power of two
+    Buckets buckets_;
+    std::size_t size_;
+    // the sum of the mixed hash values of the keys when they are cached, see key_fingerprint()
+    std::uint64_t fingerprint_;
+    std::size_t shift_;
+    // during an incremental rehash the previous bucket array, whose buckets
+    // below migrated_ are already moved; empty otherwise
+    Buckets old_buckets_;
+    std::size_t old_shift_;
+    std::size_t migrated_;
+    float max_load_factor_;
+    bool incremental_rehash_;
+    Hash hash_;
+    Pred eq_;
+    NodeAlloc node_alloc_;
+    // the access order (LRU) mode and the bounded size
+    bool access_order_;
+    std::size_t max_entries_;
+    std::function<void(Element&)> on_evict_;
+    // the incremental compact(): the next node to reallocate, null when no pass runs,
+    // and the replaced nodes, chained through chain and freed when the pass ends
+    Links* compact_cursor_;
+    NodeBase* compact_freed_;
+    // the order-statistic tree of positional_index(true), null when it is off
+    std::unique_ptr<Positions> positions_;
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+    // not copied, moved or swapped: they count what was done through this object
+    mutable linked_hash_map_stats stats_ = linked_hash_map_stats();
+#endif
 
-        for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin();
-            lhs_it != lhs.end() && rhs_it != rhs.end();
-            ++lhs_it, ++rhs_it)
-        {
-            if (lhs_it->first != rhs_it->first || lhs_it->second != rhs_it->second)
-            {
-                return false;
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = typename std::remove_const<Element>::type;
+    using allocator_type = Alloc;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = typename AllocTraits::pointer;
+    using const_pointer = typename AllocTraits::const_pointer;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = detail::Iterator<const key_type, mapped_type, Element>;
+    using const_iterator = detail::Iterator<const key_type, const mapped_type, Element>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    using eviction_callback_type = std::function<void(Element&)>;
+
+    using node_type = detail::NodeHandle<Node, NodeAlloc>;
+    using insert_return_type = detail::InsertReturnType<iterator, node_type>;
+
+
+    linked_hash_map()
+        noexcept(
+            std::is_nothrow_default_constructible<hasher>::value &&
+            std::is_nothrow_default_constructible<key_equal>::value)
+        : header_{ &header_, &header_ }, size_{ 0 }, fingerprint_{ 0 }, shift_{ 0 }, old_shift_{ 0 }, migrated_{ 0 },
+        max_load_factor_{ 1.0f }, incremental_rehash_{ false }, access_order_{ false }, max_entries_{ 0 }, compact_cursor_{ nullptr }, compact_freed_{ nullptr } {}
+
+    explicit linked_hash_map(size_type n, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
+        : header_{ &header_, &header_ }, buckets_(BucketAlloc(a)), size_{ 0 }, fingerprint_{ 0 }, shift_{ 0 },
+        old_buckets_(BucketAlloc(a)), old_shift_{ 0 }, migrated_{ 0 },
+        max_load_factor_{ 1.0f }, incremental_rehash_{ false }, hash_(hf), eq_(eql), node_alloc_(a),
+        access_order_{ false }, max_entries_{ 0 }, compact_cursor_{ nullptr }, compact_freed_{ nullptr }
+    {
+        if (n > 0)
+        {
+            rehash(n);
+        }
+    }
+
+    explicit linked_hash_map(const allocator_type& a)
+        : linked_hash_map(0, hasher(), key_equal(), a) {}
+
+    template <class InputIterator>
+    linked_hash_map(InputIterator first, InputIterator last,
+        size_type n = 0, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
+        : linked_hash_map(n, hf, eql, a)
+    {
+        insert(first, last);
+    }
+
+    linked_hash_map(const linked_hash_map& rhs)
+        : linked_hash_map(rhs, AllocTraits::select_on_container_copy_construction(rhs.get_allocator())) {}
+
+    linked_hash_map(const linked_hash_map& rhs, const allocator_type& a)
+        : linked_hash_map(0, rhs.hash_, rhs.eq_, a)
+    {
+        clone_from(rhs);
+        copy_order_policy(rhs);
+        positional_index(rhs.positional_index());
+    }
+
+    linked_hash_map(linked_hash_map&& rhs)
+        noexcept(
+            std::is_nothrow_move_constructible<hasher>::value &&
+            std::is_nothrow_move_constructible<key_equal>::value)
+        : linked_hash_map(0, hasher(), key_equal(), rhs.get_allocator())
+    {
+        swap(rhs);
+    }
+
+    // moves the nodes only when the allocators are equal,
+    // otherwise the elements are moved one by one into new nodes
+    linked_hash_map(linked_hash_map&& rhs, const allocator_type& a)
+        : linked_hash_map(0, rhs.hash_, rhs.eq_, a)
+    {
+        incremental_rehash_ = rhs.incremental_rehash_;
+        copy_order_policy(rhs);
+        if (node_alloc_ == rhs.node_alloc_)
+        {
+            swap_nodes(rhs);
+        }
+        else
+        {
+            positional_index(rhs.positional_index());
+            move_elements(rhs);
+        }
+    }
+
+    linked_hash_map(std::initializer_list<value_type> ilist, size_type n = 0,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+        : linked_hash_map(n, hf, eql, a)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    linked_hash_map(size_type n) : linked_hash_map(n, hasher(), key_equal()) {}
+
+    linked_hash_map(size_type n, const hasher& hf) : linked_hash_map(n, hf, key_equal()) {}
+
+    template <class InputIterator>
+    linked_hash_map(InputIterator f, InputIterator l, size_type n)
+        : linked_hash_map(f, l, n, hasher(), key_equal()) {}
+
+    template <class InputIterator>
+    linked_hash_map(InputIterator f, InputIterator l, size_type n, const hasher& hf)
+        : linked_hash_map(f, l, n, hf, key_equal()) {}
+
+    linked_hash_map(std::initializer_list<value_type> il, size_type n)
+        : linked_hash_map(il, n, hasher(), key_equal()) {}
+
+    linked_hash_map(std::initializer_list<value_type> il, size_type n, const hasher& hf)
+        : linked_hash_map(il, n, hf, key_equal()) {}
+
+    linked_hash_map(size_type n, const allocator_type& a)
+        : linked_hash_map(n, hasher(), key_equal(), a) {}
+
+    linked_hash_map(size_type n, const hasher& hf, const allocator_type& a)
+        : linked_hash_map(n, hf, key_equal(), a) {}
+
+    template <class InputIterator>
+    linked_hash_map(InputIterator f, InputIterator l, size_type n, const allocator_type& a)
+        : linked_hash_map(f, l, n, hasher(), key_equal(), a) {}
+
+    template <class InputIterator>
+    linked_hash_map(InputIterator f, InputIterator l, size_type n, const hasher& hf,
+        const allocator_type& a)
+        : linked_hash_map(f, l, n, hf, key_equal(), a) {}
+
+    linked_hash_map(std::initializer_list<value_type> il, size_type n, const allocator_type& a)
+        : linked_hash_map(il, n, hasher(), key_equal(), a) {}
+
+    linked_hash_map(std::initializer_list<value_type> il, size_type n, const hasher& hf,
+        const allocator_type& a)
+        : linked_hash_map(il, n, hf, key_equal(), a) {}
+
+    ~linked_hash_map() { destroy_nodes(); }
+
+    linked_hash_map& operator=(const linked_hash_map& rhs)
+    {
+        if (this != &rhs)
+        {
+            using Propagate = typename NodeAllocTraits::propagate_on_container_copy_assignment;
+            linked_hash_map tmp(rhs, Propagate::value ? rhs.get_allocator() : get_allocator());
+            move_assign(tmp, std::true_type());
+        }
+        return *this;
+    }
+
+    // takes the nodes of rhs when the allocator propagates or is equal,
+    // otherwise the elements are moved one by one into new nodes
+    linked_hash_map& operator=(linked_hash_map&& rhs)
+        noexcept(
+            NodeAllocTraits::propagate_on_container_move_assignment::value &&
+            std::is_nothrow_copy_assignable<hasher>::value &&
+            std::is_nothrow_copy_assignable<key_equal>::value)
+    {
+        if (this != &rhs)
+        {
+            move_assign(rhs, typename NodeAllocTraits::propagate_on_container_move_assignment());
+        }
+        return *this;
+    }
+
+    linked_hash_map& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+
+    allocator_type get_allocator() const noexcept { return allocator_type(node_alloc_); }
+
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type max_size() const noexcept { return NodeAllocTraits::max_size(node_alloc_); }
+
+
+    iterator begin() noexcept { return iterator(header_.next); }
+    iterator end() noexcept { return iterator(&header_); }
+    const_iterator begin() const noexcept { return const_iterator(header_.next); }
+    const_iterator end() const noexcept { return const_iterator(&header_); }
+    const_iterator cbegin() const noexcept { return const_iterator(header_.next); }
+    const_iterator cend() const noexcept { return const_iterator(&header_); }
+
+    // the newest element first
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+    // the i-th element of the order, end() for i >= size(). Both are O(log n) with
+    // positional_index(true); without it nth() walks from the nearer end of the order,
+    // and rank() back to begin()
+    iterator nth(size_type i) noexcept { return iterator(nth_links(i)); }
+    const_iterator nth(size_type i) const noexcept { return const_iterator(nth_links(i)); }
+
+    // the number of elements before it, size() for end()
+    size_type rank(const_iterator it) const noexcept
+    {
+        const Links* p = it.node_;
+        if (p == &header_)
+        {
+            return size_;
+        }
+        if (positions_ != nullptr)
+        {
+            return positions_->rank(p);
+        }
+        size_type res = 0;
+        for (; p != header_.next; p = p->prev)
+        {
+            ++res;
+        }
+        return res;
+    }
+
+    // costs 40 to 60 bytes per element outside of the nodes, and an O(log n) update
+    // by each insertion, erase and relink, also the ones of the access order mode;
+    // off by default
+    bool positional_index() const noexcept { return positions_ != nullptr; }
+
+    void positional_index(bool enabled)
+    {
+        if (!enabled)
+        {
+            positions_.reset();
+        }
+        else if (positions_ == nullptr)
+        {
+            std::unique_ptr<Positions> fresh(new Positions(get_allocator()));
+            fresh->build(&header_);
+            positions_.swap(fresh);
+        }
+    }
+
+    // k contiguous sub-ranges of the order, e.g. for parallel_for_each; some may be
+    // empty. With the positional index the split points are found in O(k log n),
+    // without it the split walks the whole order list once, in O(n) on the calling
+    // thread; dense_linked_hash_map splits in O(k)
+    std::vector<std::pair<iterator, iterator>> chunks(size_type k)
+    {
+        return chunks_of<iterator>(k);
+    }
+
+    std::vector<std::pair<const_iterator, const_iterator>> chunks(size_type k) const
+    {
+        return chunks_of<const_iterator>(k);
+    }
+
+
+    // the element is constructed in place in its node. With a key_type, or a pair
+    // of one, as the key the map is probed first, so a hit allocates nothing;
+    // other arguments, e.g. std::piecewise_construct, build the node first
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        return emplace_at(&header_, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    iterator emplace_hint(const_iterator position, Args&&... args)
+    {
+        return emplace_at(position_of(position), std::forward<Args>(args)...).first;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+
+    // the key is const in value_type, so only the mapped value is moved
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    template <class P, typename std::enable_if<
+        std::is_constructible<value_type, P&&>::value, int>::type = 0>
+    std::pair<iterator, bool> insert(P&& value)
+    {
+        return emplace(std::forward<P>(value));
+    }
+
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return insert_at(hint, value).first;
+    }
+
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        return insert_at(hint, std::move(value)).first;
+    }
+
+    template <class P, typename std::enable_if<
+        std::is_constructible<value_type, P&&>::value, int>::type = 0>
+    iterator insert(const_iterator hint, P&& value)
+    {
+        return emplace_hint(hint, std::forward<P>(value));
+    }
+
+    // a new element is linked in front of position instead of at the end,
+    // an existing key keeps its place. The hinted insert(), emplace_hint(),
+    // try_emplace() and insert_or_assign() all honor the hint this way.
+    std::pair<iterator, bool> insert_at(const_iterator position, const value_type& value)
+    {
+        return try_emplace_impl(position_of(position), hash_key(value.first), value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert_at(const_iterator position, value_type&& value)
+    {
+        return try_emplace_impl(position_of(position), hash_key(value.first), value.first,
+            std::move(value.second));
+    }
+
+    // with forward iterators of (key_type, mapped_type) pairs, the buckets are
+    // sized once up front, and the keys are hashed and their buckets prefetched
+    // in batches before probing
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        using Traits = std::iterator_traits<InputIterator>;
+        insert_range(first, last, std::integral_constant<bool,
+            std::is_base_of<std::forward_iterator_tag, typename Traits::iterator_category>::value &&
+            std::is_same<typename std::decay<decltype((*first).first)>::type, key_type>::value>());
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+
+    // the mapped value is constructed from args only if k is not there yet
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+    {
+        return try_emplace_impl(&header_, hash_key(k), k, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+    {
+        return try_emplace_impl(&header_, hash_key(k), std::move(k), std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    iterator try_emplace(const_iterator hint, const key_type& k, Args&&... args)
+    {
+        return try_emplace_impl(position_of(hint), hash_key(k), k, std::forward<Args>(args)...).first;
+    }
+
+    template <class... Args>
+    iterator try_emplace(const_iterator hint, key_type&& k, Args&&... args)
+    {
+        return try_emplace_impl(position_of(hint), hash_key(k), std::move(k),
+            std::forward<Args>(args)...).first;
+    }
+
+    // the same as insert() and try_emplace(), for callers that already have
+    // h == hash_function()(key), e.g. from hashing a batch of keys up front
+    std::pair<iterator, bool> insert_hashed(size_type h, const value_type& value)
+    {
+        return try_emplace_impl(&header_, h, value.first, value.second);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace_hashed(size_type h, const key_type& k, Args&&... args)
+    {
+        return try_emplace_impl(&header_, h, k, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace_hashed(size_type h, key_type&& k, Args&&... args)
+    {
+        return try_emplace_impl(&header_, h, std::move(k), std::forward<Args>(args)...);
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+    {
+        return insert_or_assign_impl(&header_, hash_key(k), k, std::forward<M>(obj));
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj)
+    {
+        return insert_or_assign_impl(&header_, hash_key(k), std::move(k), std::forward<M>(obj));
+    }
+
+    template <class M>
+    iterator insert_or_assign(const_iterator hint, const key_type& k, M&& obj)
+    {
+        return insert_or_assign_impl(position_of(hint), hash_key(k), k, std::forward<M>(obj)).first;
+    }
+
+    template <class M>
+    iterator insert_or_assign(const_iterator hint, key_type&& k, M&& obj)
+    {
+        return insert_or_assign_impl(position_of(hint), hash_key(k), std::move(k),
+            std::forward<M>(obj)).first;
+    }
+
+
+    // O(1) relinks in the order list: nothing is allocated, hashed or rehashed,
+    // and no iterator is invalidated
+    void move_to_back(const_iterator it) noexcept
+    {
+        relink_before(position_of(it), &header_);
+    }
+
+    void move_to_front(const_iterator it) noexcept
+    {
+        relink_before(position_of(it), header_.next);
+    }
+
+    // relinks it in front of pos, which may be end()
+    void move_before(const_iterator pos, const_iterator it) noexcept
+    {
+        relink_before(position_of(it), position_of(pos));
+    }
+
+
+    insert_return_type insert(node_type&& nh)
+    {
+        return insert_node_handle(&header_, std::move(nh));
+    }
+
+    // a new node goes in front of hint
+    iterator insert(const_iterator hint, node_type&& nh)
+    {
+        return insert_node_handle(position_of(hint), std::move(nh)).position;
+    }
+
+    // unlinks the element without destroying it
+    node_type extract(const_iterator position)
+    {
+        NodeBase* node = const_cast<NodeBase*>(position.node());
+        unlink_node(node);
+        return node_type(static_cast<Node*>(node), node_alloc_);
+    }
+
+    node_type extract(const key_type& k) { return extract_key(k); }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value &&
+        !std::is_convertible<K, iterator>::value &&
+        !std::is_convertible<K, const_iterator>::value, int>::type = 0>
+    node_type extract(K&& k) { return extract_key(k); }
+
+    // moves the nodes whose keys are not here yet from source, in its order,
+    // to the end of this map. Nothing is allocated or copied.
+    template <class H2, class P2>
+    void merge(linked_hash_map<Key, T, H2, P2, Alloc>& source)
+    {
+        using Source = linked_hash_map<Key, T, H2, P2, Alloc>;
+        static_assert(std::is_same<Node, typename Source::Node>::value,
+            "the maps must agree on cache_hash_code to share their nodes");
+        assert(node_alloc_ == source.node_alloc_ && "merge() needs equal allocators");
+
+        // a stateless hasher of the same type gives the same values,
+        // so the stored hash values are still good
+        using SameHash = std::integral_constant<bool,
+            std::is_same<H2, Hash>::value && std::is_empty<Hash>::value && CacheHash::value>;
+        for (Links* p = source.header_.next; p != &source.header_;)
+        {
+            Node* node = static_cast<Node*>(p);
+            p = p->next;
+            const size_type h = merge_hash(source, node, SameHash());
+            if (find_node(key_of(node), h) == nullptr)
+            {
+                grow_if_full();
+                source.unlink_node(node);
+                link_node(h, node, &header_);
+            }
+        }
+    }
+
+    template <class H2, class P2>
+    void merge(linked_hash_map<Key, T, H2, P2, Alloc>&& source)
+    {
+        merge(source);
+    }
+
+
+    hasher hash_function() const { return hash_; }
+    key_equal key_eq() const { return eq_; }
+
+
+    // all zero unless PPSTD_LINKED_HASH_MAP_STATS is defined
+    linked_hash_map_stats stats() const noexcept
+    {
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+        return stats_;
+#else
+        return linked_hash_map_stats();
+#endif
+    }
+
+    void reset_stats() noexcept
+    {
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+        stats_ = linked_hash_map_stats();
+#endif
+    }
+
+    // O(1), but walks the replaced nodes during a compact() pass
+    linked_hash_map_memory memory_usage() const noexcept
+    {
+        linked_hash_map_memory res = linked_hash_map_memory();
+        res.buckets = (buckets_.capacity() + old_buckets_.capacity()) * sizeof(NodeBase*);
+        if (positions_ != nullptr)
+        {
+            res.buckets += sizeof(Positions) + positions_->memory();
+        }
+        res.node_overhead = size_ * node_overhead_bytes();
+        res.payload = size_ * sizeof(value_type);
+        for (const NodeBase* node = compact_freed_; node != nullptr; node = node->chain)
+        {
+            res.spare += sizeof(Node);
+        }
+        return res;
+    }
+
+    // the bytes of a node beyond its key value pair
+    static constexpr size_type node_overhead_bytes() { return sizeof(Node) - sizeof(value_type); }
+
+
+    iterator erase(const_iterator position)
+    {
+        return erase(iterator(const_cast<Links*>(position.node_)));
+    }
+
+    iterator erase(iterator position)
+    {
+        NodeBase* node = position.node();
+        iterator res(node->next);
+        unlink_node(node);
+        destroy_node(node);
+        return res;
+    }
+
+    size_type erase(const key_type& k) { return erase_key(k); }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value &&
+        !std::is_convertible<K, iterator>::value &&
+        !std::is_convertible<K, const_iterator>::value, int>::type = 0>
+    size_type erase(K&& k) { return erase_key(k); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        Links* const stop = const_cast<Links*>(last.node_);
+        if (first.node_ == header_.next && stop == &header_)
+        {
+            clear();
+            return end();
+        }
+        for (Links* p = const_cast<Links*>(first.node_); p != stop;)
+        {
+            NodeBase* node = static_cast<NodeBase*>(p);
+            p = p->next;
+            unlink_node(node);
+            destroy_node(node);
+        }
+        return iterator(stop);
+    }
+
+    void clear() noexcept
+    {
+        destroy_nodes();
+        std::fill(buckets_.begin(), buckets_.end(), nullptr);
+        Buckets(buckets_.get_allocator()).swap(old_buckets_);
+        header_.prev = header_.next = &header_;
+        size_ = 0;
+        fingerprint_ = 0;
+        if (positions_ != nullptr)
+        {
+            positions_->clear();
+        }
+    }
+
+
+    // the allocators are swapped if they propagate on swap,
+    // otherwise they must be equal, as with the std containers
+    void swap(linked_hash_map& rhs) noexcept
+    {
+        using std::swap;
+        swap_nodes(rhs);
+        swap(max_load_factor_, rhs.max_load_factor_);
+        swap(incremental_rehash_, rhs.incremental_rehash_);
+        swap(hash_, rhs.hash_);
+        swap(eq_, rhs.eq_);
+        swap_allocator(rhs, typename NodeAllocTraits::propagate_on_container_swap());
+        swap(access_order_, rhs.access_order_);
+        swap(max_entries_, rhs.max_entries_);
+        swap(on_evict_, rhs.on_evict_);
+    }
+
+
+    // in the access order mode, like java.util.LinkedHashMap(accessOrder = true),
+    // a hit of the non-const find(), at(), operator[], try_emplace(),
+    // insert() or insert_or_assign() moves the element to the end in O(1),
+    // so begin() is always the least recently used one
+    bool access_order() const noexcept { return access_order_; }
+    void access_order(bool enabled) noexcept { access_order_ = enabled; }
+
+    // 0 means unbounded; otherwise inserting beyond n elements evicts from begin(),
+    // but never the new element, also when a hint linked it in front
+    size_type max_entries() const noexcept { return max_entries_; }
+
+    void max_entries(size_type n)
+    {
+        max_entries_ = n;
+        evict_overflow();
+    }
+
+    // called with each evicted element right before it is destroyed,
+    // and it must not modify the map
+    void eviction_callback(eviction_callback_type fn) { on_evict_ = std::move(fn); }
+
+
+    iterator find(const key_type& k) { return touch(find_iterator(k)); }
+    const_iterator find(const key_type& k) const { return find_iterator(k); }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    iterator find(const K& k) { return touch(find_iterator(k)); }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    const_iterator find(const K& k) const { return find_iterator(k); }
+
+    // h must be hash_function()(k)
+    iterator find(const key_type& k, size_type h)
+    {
+        NodeBase* node = find_node(k, h);
+        return node == nullptr ? end() : iterator(touch(node));
+    }
+
+    const_iterator find(const key_type& k, size_type h) const
+    {
+        const NodeBase* node = find_node(k, h);
+        return node == nullptr ? end() : const_iterator(node);
+    }
+
+    bool contains(const key_type& k, size_type h) const { return find_node(k, h) != nullptr; }
+
+    size_type count(const key_type& k) const { return contains(k) ? 1 : 0; }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    size_type count(const K& k) const { return contains(k) ? 1 : 0; }
+
+    bool contains(const key_type& k) const { return find_node(k, hash_key(k)) != nullptr; }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    bool contains(const K& k) const { return find_node(k, hash_key(k)) != nullptr; }
+
+    // the batched find: writes one iterator per key, end() for a miss. The keys are
+    // hashed in batches of 16 and their buckets and chain heads prefetched before
+    // any is probed, so the cache misses of a batch overlap
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out)
+    {
+        find_batched(first, last, [this, &out](NodeBase* node)
+        {
+            *out++ = node != nullptr ? iterator(touch(node)) : end();
+        });
+        return out;
+    }
+
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const
+    {
+        find_batched(first, last, [this, &out](const NodeBase* node)
+        {
+            *out++ = node != nullptr ? const_iterator(node) : end();
+        });
+        return out;
+    }
+
+    // writes one bool per key
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator contains_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const
+    {
+        find_batched(first, last, [&out](const NodeBase* node) { *out++ = node != nullptr; });
+        return out;
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type& k) { return equal_range_of(k); }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return equal_range_of(k);
+    }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    std::pair<iterator, iterator> equal_range(const K& k) { return equal_range_of(k); }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    std::pair<const_iterator, const_iterator> equal_range(const K& k) const
+    {
+        return equal_range_of(k);
+    }
+
+
+    mapped_type& operator[](const key_type& k)
+    {
+        return try_emplace(k).first->second;
+    }
+
+    mapped_type& operator[](key_type&& k)
+    {
+        return try_emplace(std::move(k)).first->second;
+    }
+
+
+    mapped_type& at(const key_type& k) { return touch(at_node(k))->value.second; }
+    const mapped_type& at(const key_type& k) const { return at_node(k)->value.second; }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    mapped_type& at(const K& k) { return touch(at_node(k))->value.second; }
+
+    template <class K, class H = hasher, class P = key_equal, typename std::enable_if<
+        detail::is_transparent_lookup<H, P>::value, int>::type = 0>
+    const mapped_type& at(const K& k) const { return at_node(k)->value.second; }
+
+
+    size_type bucket_count() const noexcept { return buckets_.size(); }
+    size_type max_bucket_count() const noexcept { return buckets_.max_size(); }
+
+
+    size_type bucket_size(size_type n) const
+    {
+        size_type res = 0;
+        for (const NodeBase* node = buckets_[n]; node != nullptr; node = node->chain)
+        {
+            ++res;
+        }
+        // the array doubled, so bucket n gets its elements from old bucket n / 2
+        if (!old_buckets_.empty() && n / 2 >= migrated_)
+        {
+            for (const NodeBase* node = old_buckets_[n / 2]; node != nullptr; node = node->chain)
+            {
+                res += bucket_index(node_hash(node)) == n ? 1 : 0;
+            }
+        }
+        return res;
+    }
+
+    size_type bucket(const key_type& k) const
+    {
+        return buckets_.empty() ? 0 : bucket_index(hash_key(k));
+    }
+
+
+    float load_factor() const noexcept
+    {
+        return buckets_.empty() ? 0.0f : static_cast<float>(size_) / buckets_.size();
+    }
+
+    float max_load_factor() const noexcept { return max_load_factor_; }
+
+    void max_load_factor(float z)
+    {
+        max_load_factor_ = z;
+        rehash(0);
+    }
+
+    // finishes a running incremental rehash at once
+    void rehash(size_type n)
+    {
+        n = std::max(n, static_cast<size_type>(std::ceil(size_ / max_load_factor_)));
+        if (n == 0)
+        {
+            return;
+        }
+        size_type count = detail::min_bucket_count();
+        size_type shift = sizeof(size_type) * CHAR_BIT - 3;
+        while (count < n)
+        {
+            count <<= 1;
+            --shift;
+        }
+        if (count == buckets_.size())
+        {
+            migrate_buckets(static_cast<size_type>(-1));
+            return;
+        }
+
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#endif
+        Buckets fresh(count, nullptr, buckets_.get_allocator());
+        for (Links* p = header_.next; p != &header_; p = p->next)
+        {
+            NodeBase* node = static_cast<NodeBase*>(p);
+            link_chain(fresh[bucket_index(node_hash(node), shift)], node);
+        }
+        buckets_.swap(fresh);
+        shift_ = shift;
+        Buckets(buckets_.get_allocator()).swap(old_buckets_);
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+        ++stats_.rehashes;
+        stats_.rehash_nanoseconds += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+#endif
+    }
+
+    void reserve(size_type n)
+    {
+        rehash(static_cast<size_type>(std::ceil(n / max_load_factor_)));
+    }
+
+    // the fewest buckets for the size and the load factor, none for an empty map
+    void shrink_to_fit()
+    {
+        if (size_ == 0)
+        {
+            Buckets(buckets_.get_allocator()).swap(buckets_);
+            Buckets(buckets_.get_allocator()).swap(old_buckets_);
+            shift_ = 0;
+            return;
+        }
+        rehash(0);
+    }
+
+    // when enabled, growing allocates the doubled bucket array, and the elements
+    // move over a few buckets per insert instead of all at once; lookups probe
+    // both arrays until then. The bucket interface describes the new array
+    bool incremental_rehash() const noexcept { return incremental_rehash_; }
+    void incremental_rehash(bool enabled) noexcept { incremental_rehash_ = enabled; }
+
+    bool rehash_in_progress() const noexcept { return !old_buckets_.empty(); }
+
+    // reallocates the nodes one after another in the order of the list, so a map
+    // scattered over the heap by a long insert/erase churn is iterated like a freshly
+    // loaded one, then shrinks the buckets; invalidates iterators, pointers and references
+    void compact()
+    {
+        compact(static_cast<size_type>(-1));
+        shrink_to_fit();
+    }
+
+    // the incremental compact(): reallocates at most max_work nodes per call and
+    // returns true when the pass begun by the first call has reached the end.
+    // The replaced nodes are freed when the pass ends, until then the map holds up
+    // to two nodes per element. The iterators to the reallocated elements are
+    // invalidated; elements inserted or moved during a pass may be skipped
+    bool compact(size_type max_work)
+    {
+        if (compact_cursor_ == nullptr)
+        {
+            compact_cursor_ = header_.next;
+        }
+        for (; max_work > 0 && compact_cursor_ != &header_; --max_work)
+        {
+            compact_cursor_ = relocate_node(static_cast<NodeBase*>(compact_cursor_))->next;
+        }
+        if (compact_cursor_ != &header_)
+        {
+            return false;
+        }
+        finish_compaction();
+        return true;
+    }
+
+    bool compaction_in_progress() const noexcept { return compact_cursor_ != nullptr; }
+
+
+    // an order-insensitive fingerprint of the keys. With cached hash values it is kept
+    // by each insertion and erase in O(1), from the stored hash; otherwise it is computed
+    // here in O(n), so an erase never hashes. With a stateless hasher, equal keys give
+    // equal fingerprints, so unequal ones prove that two maps differ; operator== and
+    // equal_unordered() check the kept ones before walking. The mapped values are not
+    // in it, they change through references
+    std::uint64_t key_fingerprint() const { return key_fingerprint(CacheHash()); }
+
+    // the same elements in the same order
+    friend bool operator==(const linked_hash_map& lhs, const linked_hash_map& rhs)
+    {
+        return lhs.size_ == rhs.size_ && lhs.same_fingerprint(rhs) &&
+            std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    friend bool operator!=(const linked_hash_map& lhs, const linked_hash_map& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    // the same elements in any order: each key of lhs is probed in rhs, with its
+    // cached hash value when the hasher is stateless
+    friend bool equal_unordered(const linked_hash_map& lhs, const linked_hash_map& rhs)
+    {
+        if (lhs.size_ != rhs.size_ || !lhs.same_fingerprint(rhs))
+        {
+            return false;
+        }
+        for (const Links* p = lhs.header_.next; p != &lhs.header_; p = p->next)
+        {
+            const NodeBase* node = static_cast<const NodeBase*>(p);
+            const size_type h = std::is_empty<Hash>::value ? lhs.node_hash(node) : rhs.hash_key(key_of(node));
+            const NodeBase* other = rhs.find_node(key_of(node), h);
+            if (other == nullptr || !same_mapped(node, other, IsSet()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend void swap(linked_hash_map& lhs, linked_hash_map& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+private:
+    template <class, class, class, class, class> friend class linked_hash_map;
+    template <class> friend struct detail::SnapshotAccess;
+
+    static size_type bucket_index(size_type h, size_type shift) noexcept
+    {
+        return (h * detail::hash_multiplier()) >> shift;
+    }
+
+    size_type bucket_index(size_type h) const noexcept { return bucket_index(h, shift_); }
+
+    Links* nth_links(size_type i) const noexcept
+    {
+        const Links* p = &header_;
+        if (i < size_ && positions_ != nullptr)
+        {
+            p = positions_->nth(i);
+        }
+        else if (i < size_ / 2)
+        {
+            for (p = header_.next; i > 0; --i)
+            {
+                p = p->next;
+            }
+        }
+        else if (i < size_)
+        {
+            for (p = header_.prev; ++i < size_;)
+            {
+                p = p->prev;
+            }
+        }
+        return const_cast<Links*>(p);
+    }
+
+    template <class Iter>
+    std::vector<std::pair<Iter, Iter>> chunks_of(size_type k) const
+    {
+        k = std::max<size_type>(k, 1);
+        std::vector<std::pair<Iter, Iter>> res;
+        res.reserve(k);
+        Links* p = header_.next;
+        size_type pos = 0;
+        for (size_type i = 1; i <= k; ++i)
+        {
+            Links* first = p;
+            const size_type last = size_ / k * i + size_ % k * i / k;
+            if (positions_ != nullptr)
+            {
+                p = nth_links(last);
+            }
+            else
+            {
+                for (; pos < last; ++pos)
+                {
+                    p = p->next;
+                }
+            }
+            res.emplace_back(Iter(first), Iter(p));
+        }
+        return res;
+    }
+
+    template <class K>
+    size_type hash_key(const K& k) const
+    {
+        count_stat(&linked_hash_map_stats::hash_calls);
+        return hash_(k);
+    }
+
+    static const key_type& key_of(const NodeBase* node) noexcept
+    {
+        return detail::NodeElement<Key, T>::key(node->value);
+    }
+
+    std::uint64_t key_fingerprint(std::true_type) const noexcept { return fingerprint_; }
+
+    std::uint64_t key_fingerprint(std::false_type) const
+    {
+        std::uint64_t res = 0;
+        for (const Links* p = header_.next; p != &header_; p = p->next)
+        {
+            res += detail::fingerprint_mix(hash_key(key_of(static_cast<const NodeBase*>(p))));
+        }
+        return res;
+    }
+
+    // a stateful hasher may hash the same keys differently in two maps,
+    // and without cached hash values the fingerprint is not kept
+    bool same_fingerprint(const linked_hash_map& rhs) const noexcept
+    {
+        return !(std::is_empty<Hash>::value && CacheHash::value) || fingerprint_ == rhs.fingerprint_;
+    }
+
+    static void add_fingerprint(std::uint64_t& fp, size_type h, std::true_type) noexcept
+    {
+        fp += detail::fingerprint_mix(h);
+    }
+
+    static void add_fingerprint(std::uint64_t&, size_type, std::false_type) noexcept {}
+
+    static bool same_mapped(const NodeBase* a, const NodeBase* b, std::false_type)
+    {
+        return a->value.second == b->value.second;
+    }
+
+    static bool same_mapped(const NodeBase*, const NodeBase*, std::true_type) noexcept { return true; }
+
+    void count_stat(std::size_t linked_hash_map_stats::* counter) const noexcept
+    {
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+        ++(stats_.*counter);
+#else
+        (void)counter;
+#endif
+    }
+
+    void count_lookup(size_type probes) const noexcept
+    {
+#ifdef PPSTD_LINKED_HASH_MAP_STATS
+        ++stats_.lookups;
+        stats_.probes += probes;
+        stats_.longest_probe = std::max(stats_.longest_probe, probes);
+#else
+        (void)probes;
+#endif
+    }
+
+    template <class... Args>
+    Node* create_node(Args&&... args)
+    {
+        Node* node = std::addressof(*NodeAllocTraits::allocate(node_alloc_, 1));
+        try
+        {
+            NodeAllocTraits::construct(node_alloc_, node, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            NodeAllocTraits::deallocate(node_alloc_, node, 1);
+            throw;
+        }
+        count_stat(&linked_hash_map_stats::node_allocations);
+        return node;
+    }
+
+    void destroy_node(NodeBase* base) noexcept
+    {
+        Node* node = static_cast<Node*>(base);
+        NodeAllocTraits::destroy(node_alloc_, node);
+        NodeAllocTraits::deallocate(node_alloc_, node, 1);
+        count_stat(&linked_hash_map_stats::node_frees);
+    }
+
+    size_type node_hash(const NodeBase* node) const { return node_hash(node, CacheHash()); }
+
+    size_type node_hash(const NodeBase* node, std::true_type) const noexcept
+    {
+        return static_cast<const Node*>(node)->hash;
+    }
+
+    size_type node_hash(const NodeBase* node, std::false_type) const
+    {
+        return hash_key(key_of(node));
+    }
+
+    static void store_hash(Node* node, size_type h, std::true_type) noexcept { node->hash = h; }
+    static void store_hash(Node*, size_type, std::false_type) noexcept {}
+
+    template <class K>
+    bool node_matches(const NodeBase* node, const K& k, size_type h, std::true_type) const
+    {
+        return static_cast<const Node*>(node)->hash == h && eq_(key_of(node), k);
+    }
+
+    template <class K>
+    bool node_matches(const NodeBase* node, const K& k, size_type, std::false_type) const
+    {
+        return eq_(key_of(node), k);
+    }
+
+    void destroy_nodes() noexcept
+    {
+        for (Links* p = header_.next; p != &header_;)
+        {
+            NodeBase* node = static_cast<NodeBase*>(p);
+            p = p->next;
+            destroy_node(node);
+        }
+        finish_compaction();
+    }
+
+    void finish_compaction() noexcept
+    {
+        while (compact_freed_ != nullptr)
+        {
+            NodeBase* node = compact_freed_;
+            compact_freed_ = node->chain;
+            destroy_node(node);
+        }
+        compact_cursor_ = nullptr;
+    }
+
+    // a new node takes the place of node in its chain and in the order list; the
+    // element is moved unless that could throw, then it is copied. node is kept
+    // until the pass ends, so the new nodes do not reuse the memory of the old ones
+    NodeBase* relocate_node(NodeBase* node)
+    {
+        Node* fresh = relocated(static_cast<Node*>(node), std::integral_constant<bool,
+            std::is_nothrow_move_constructible<Key>::value &&
+            std::is_nothrow_move_constructible<T>::value>());
+        copy_hash(fresh, node, CacheHash());
+        fresh->chain = node->chain;
+        fresh->pchain = node->pchain;
+        *fresh->pchain = fresh;
+        if (fresh->chain != nullptr)
+        {
+            fresh->chain->pchain = &fresh->chain;
+        }
+        fresh->prev = node->prev;
+        fresh->next = node->next;
+        fresh->prev->next = fresh;
+        fresh->next->prev = fresh;
+        if (positions_ != nullptr)
+        {
+            positions_->rename(node, fresh);
+        }
+        node->chain = compact_freed_;
+        compact_freed_ = node;
+        return fresh;
+    }
+
+    Node* relocated(Node* node, std::true_type)
+    {
+        return moved_node(node, IsSet());
+    }
+
+    Node* moved_node(Node* node, std::false_type)
+    {
+        return create_node(std::move(const_cast<Key&>(node->value.first)), std::move(node->value.second));
+    }
+
+    Node* moved_node(Node* node, std::true_type)
+    {
+        return create_node(std::move(const_cast<Key&>(node->value)));
+    }
+
+    Node* relocated(Node* node, std::false_type)
+    {
+        return create_node(node->value);
+    }
+
+    static void copy_hash(Node* to, const NodeBase* from, std::true_type) noexcept
+    {
+        to->hash = static_cast<const Node*>(from)->hash;
+    }
+
+    static void copy_hash(Node*, const NodeBase*, std::false_type) noexcept {}
+
+    // K is key_type, or any key type accepted by transparent functors
+    template <class K>
+    NodeBase* find_node(const K& k, size_type h) const
+    {
+        if (buckets_.empty())
+        {
+            return nullptr;
+        }
+        size_type probes = 0;
+        NodeBase* node = find_in_chain(buckets_[bucket_index(h)], k, h, probes);
+        if (node == nullptr && !old_buckets_.empty())
+        {
+            const size_type old = bucket_index(h, old_shift_);
+            if (old >= migrated_)
+            {
+                node = find_in_chain(old_buckets_[old], k, h, probes);
+            }
+        }
+        count_lookup(probes);
+        return node;
+    }
+
+    template <class K>
+    NodeBase* find_in_chain(NodeBase* node, const K& k, size_type h, size_type& probes) const
+    {
+        for (; node != nullptr; node = node->chain)
+        {
+            ++probes;
+            if (node_matches(node, k, h, CacheHash()))
+            {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    template <class K>
+    iterator find_iterator(const K& k) const
+    {
+        NodeBase* node = find_node(k, hash_key(k));
+        return node == nullptr ? iterator(const_cast<Links*>(&header_)) : iterator(node);
+    }
+
+    template <class K>
+    std::pair<iterator, iterator> equal_range_of(const K& k) const
+    {
+        iterator lower_it = find_iterator(k);
+        iterator upper_it = lower_it;
+        if (upper_it.node_ != &header_)
+        {
+            ++upper_it;
+        }
+        return std::pair<iterator, iterator>{lower_it, upper_it};
+    }
+
+    template <class K>
+    NodeBase* at_node(const K& k) const
+    {
+        NodeBase* node = find_node(k, hash_key(k));
+        if (node == nullptr)
+        {
+            count_stat(&linked_hash_map_stats::at_misses);
+            throw std::out_of_range("linked_hash_map::at: key not found");
+        }
+        return node;
+    }
+
+    template <class K>
+    size_type erase_key(const K& k)
+    {
+        NodeBase* node = find_node(k, hash_key(k));
+        if (node == nullptr)
+        {
+            return 0;
+        }
+        unlink_node(node);
+        destroy_node(node);
+        return 1;
+    }
+
+    // the keys are key_type, or any type accepted by transparent functors.
+    // A rolling pipeline: the bucket of key i + 16 and the chain head of key i + 8
+    // are prefetched while key i is probed
+    template <class ForwardIterator, class F>
+    void find_batched(ForwardIterator first, ForwardIterator last, F fn) const
+    {
+        constexpr size_type window = detail::bulk_batch_size();
+        size_type hashes[window];
+        if (buckets_.empty())
+        {
+            for (; first != last; ++first)
+            {
+                fn(find_node(*first, hash_key(*first)));
             }
+            return;
+        }
+        ForwardIterator ahead = first;
+        size_type hashed = 0;
+        for (; hashed < window && ahead != last; ++hashed, ++ahead)
+        {
+            hashes[hashed] = hash_key(*ahead);
+            detail::prefetch(&buckets_[bucket_index(hashes[hashed])]);
+        }
+        for (size_type i = 0; first != last; ++i, ++first)
+        {
+            if (i + window / 2 < hashed)
+            {
+                detail::prefetch(buckets_[bucket_index(hashes[(i + window / 2) % window])]);
+            }
+            const size_type h = hashes[i % window];
+            if (ahead != last)
+            {
+                hashes[hashed % window] = hash_key(*ahead);
+                detail::prefetch(&buckets_[bucket_index(hashes[hashed % window])]);
+                ++hashed;
+                ++ahead;
+            }
+            fn(find_node(*first, h));
         }
-        return true;
     }
 
-    friend bool operator!=(linked_hash_map& lhs, linked_hash_map& rhs)
+    template <class InputIterator>
+    void insert_range(InputIterator first, InputIterator last, std::false_type)
     {
-        return !(lhs == rhs);
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
     }
 
-    friend void swap(linked_hash_map& lhs, linked_hash_map& rhs)
+    template <class ForwardIterator>
+    void insert_range(ForwardIterator first, ForwardIterator last, std::true_type)
     {
-        lhs.swap(rhs);
+        reserve(size_ + static_cast<size_type>(std::distance(first, last)));
+
+        size_type hashes[detail::bulk_batch_size()];
+        while (first != last)
+        {
+            ForwardIterator batch = first;
+            size_type n = 0;
+            for (; n < detail::bulk_batch_size() && first != last; ++n, ++first)
+            {
+                hashes[n] = hash_key((*first).first);
+                detail::prefetch(&buckets_[bucket_index(hashes[n])]);
+            }
+            for (size_type i = 0; i < n; ++i)
+            {
+                detail::prefetch(buckets_[bucket_index(hashes[i])]);
+            }
+            for (size_type i = 0; i < n; ++i, ++batch)
+            {
+                try_emplace_impl(&header_, hashes[i], (*batch).first, (*batch).second);
+            }
+        }
+    }
+
+    // takes over the node of nh, if its key is not there yet,
+    // otherwise nh is given back in the result. The allocators must be equal.
+    insert_return_type insert_node_handle(Links* before, node_type&& nh)
+    {
+        if (nh.empty())
+        {
+            return insert_return_type{ end(), false, node_type() };
+        }
+        assert(nh.alloc() == node_alloc_ && "the node comes from an unequal allocator");
+        const size_type h = hash_key(nh.key());
+        NodeBase* node = find_node(nh.key(), h);
+        if (node != nullptr)
+        {
+            return insert_return_type{ iterator(touch(node)), false, std::move(nh) };
+        }
+        // a failed rehash leaves the node in nh
+        grow_if_full();
+        node = link_node(h, nh.release(), before);
+        return insert_return_type{ iterator(node), true, node_type() };
+    }
+
+    template <class K>
+    node_type extract_key(const K& k)
+    {
+        NodeBase* node = find_node(k, hash_key(k));
+        if (node == nullptr)
+        {
+            return node_type();
+        }
+        unlink_node(node);
+        return node_type(static_cast<Node*>(node), node_alloc_);
+    }
+
+    template <class Source>
+    static size_type merge_hash(const Source&, const Node* node, std::true_type) noexcept
+    {
+        return node->hash;
+    }
+
+    template <class Source>
+    size_type merge_hash(const Source&, const Node* node, std::false_type) const
+    {
+        return hash_key(key_of(node));
+    }
+
+    template <class K, class M, typename std::enable_if<
+        std::is_same<typename std::decay<K>::type, key_type>::value, int>::type = 0>
+    std::pair<iterator, bool> emplace_at(Links* before, K&& k, M&& obj)
+    {
+        return try_emplace_impl(before, hash_key(k), std::forward<K>(k), std::forward<M>(obj));
+    }
+
+    template <class P, typename std::enable_if<
+        detail::is_pair_of_key<typename std::decay<P>::type, key_type>::value, int>::type = 0>
+    std::pair<iterator, bool> emplace_at(Links* before, P&& value)
+    {
+        return try_emplace_impl(before, hash_key(value.first),
+            std::forward<P>(value).first, std::forward<P>(value).second);
+    }
+
+    // the key is only known once the node is built
+    template <class... Args>
+    std::pair<iterator, bool> emplace_at(Links* before, Args&&... args)
+    {
+        Node* node = create_node(std::forward<Args>(args)...);
+        NodeBase* hit;
+        size_type h;
+        try
+        {
+            h = hash_key(key_of(node));
+            hit = find_node(key_of(node), h);
+        }
+        catch (...)
+        {
+            destroy_node(node);
+            throw;
+        }
+        if (hit != nullptr)
+        {
+            destroy_node(node);
+            return std::pair<iterator, bool>{iterator(touch(hit)), false};
+        }
+        return std::pair<iterator, bool>{iterator(insert_node(h, node, before)), true};
+    }
+
+    // one hash and one probe, and no exception on a miss
+    template <class K, class... Args>
+    std::pair<iterator, bool> try_emplace_impl(Links* before, size_type h, K&& k, Args&&... args)
+    {
+        NodeBase* node = find_node(k, h);
+        if (node != nullptr)
+        {
+            return std::pair<iterator, bool>{iterator(touch(node)), false};
+        }
+        node = insert_node(h, create_element(IsSet(), std::forward<K>(k), std::forward<Args>(args)...), before);
+        return std::pair<iterator, bool>{iterator(node), true};
+    }
+
+    template <class K, class... Args>
+    Node* create_element(std::false_type, K&& k, Args&&... args)
+    {
+        return create_node(std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(k)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <class K>
+    Node* create_element(std::true_type, K&& k)
+    {
+        return create_node(std::forward<K>(k));
+    }
+
+    template <class K, class M>
+    std::pair<iterator, bool> insert_or_assign_impl(Links* before, size_type h, K&& k, M&& obj)
+    {
+        NodeBase* node = find_node(k, h);
+        if (node != nullptr)
+        {
+            node->value.second = std::forward<M>(obj);
+            return std::pair<iterator, bool>{iterator(touch(node)), false};
+        }
+        node = insert_node(h, create_node(std::forward<K>(k), std::forward<M>(obj)), before);
+        return std::pair<iterator, bool>{iterator(node), true};
+    }
+
+    // links a new node into its bucket and in front of before in the order list,
+    // the node is destroyed if growing the bucket array throws
+    NodeBase* insert_node(size_type h, Node* node, Links* before)
+    {
+        try
+        {
+            grow_if_full();
+        }
+        catch (...)
+        {
+            count_stat(&linked_hash_map_stats::insert_rollbacks);
+            destroy_node(node);
+            throw;
+        }
+        return link_node(h, node, before);
+    }
+
+    // makes room for one more element, and moves on a running incremental rehash
+    void grow_if_full()
+    {
+        if (positions_ != nullptr)
+        {
+            positions_->reserve(size_ + 1);
+        }
+        migrate_buckets(detail::rehash_step());
+        if (size_ + 1 > max_load_factor_ * buckets_.size())
+        {
+            if (incremental_rehash_ && !buckets_.empty())
+            {
+                begin_rehash();
+            }
+            else
+            {
+                rehash(std::max(buckets_.size() * 2, detail::min_bucket_count()));
+            }
+        }
+    }
+
+    // the doubled array becomes buckets_, the nodes stay in old_buckets_ for now
+    void begin_rehash()
+    {
+        migrate_buckets(static_cast<size_type>(-1));
+        Buckets fresh(buckets_.size() * 2, nullptr, buckets_.get_allocator());
+        old_buckets_.swap(buckets_);
+        buckets_.swap(fresh);
+        old_shift_ = shift_;
+        --shift_;
+        migrated_ = 0;
+        count_stat(&linked_hash_map_stats::rehashes);
+    }
+
+    // moves the nodes of up to n old buckets; each node leaves its old chain first,
+    // so a throwing hash function leaves both arrays consistent
+    void migrate_buckets(size_type n)
+    {
+        if (old_buckets_.empty())
+        {
+            return;
+        }
+        for (; n > 0 && migrated_ < old_buckets_.size(); --n, ++migrated_)
+        {
+            NodeBase*& head = old_buckets_[migrated_];
+            while (head != nullptr)
+            {
+                NodeBase* node = head;
+                const size_type h = node_hash(node);
+                head = node->chain;
+                if (head != nullptr)
+                {
+                    head->pchain = &head;
+                }
+                link_chain(buckets_[bucket_index(h)], node);
+            }
+        }
+        if (migrated_ == old_buckets_.size())
+        {
+            Buckets(buckets_.get_allocator()).swap(old_buckets_);
+        }
+    }
+
+    NodeBase* link_node(size_type h, Node* node, Links* before)
+    {
+        store_hash(node, h, CacheHash());
+        link_chain(buckets_[bucket_index(h)], node);
+        link_before(node, before);
+        index_before(node, before);
+        ++size_;
+        add_fingerprint(fingerprint_, h, CacheHash());
+        evict_overflow(node);
+        return node;
+    }
+
+    static Links* position_of(const_iterator it) noexcept
+    {
+        return const_cast<Links*>(it.node_);
+    }
+
+    static void link_before(Links* node, Links* before) noexcept
+    {
+        node->prev = before->prev;
+        node->next = before;
+        before->prev->next = node;
+        before->prev = node;
+    }
+
+    // grow_if_full() made room in the positional index
+    void index_before(const Links* node, const Links* before) noexcept
+    {
+        if (positions_ != nullptr)
+        {
+            positions_->insert_before(node, before == &header_ ? nullptr : before);
+        }
+    }
+
+    // the O(1) splice of one node in the order list, the buckets are untouched
+    void relink_before(Links* node, Links* before) noexcept
+    {
+        if (node != before && node->next != before)
+        {
+            if (node == compact_cursor_)
+            {
+                compact_cursor_ = node->next;
+            }
+            node->prev->next = node->next;
+            node->next->prev = node->prev;
+            link_before(node, before);
+            if (positions_ != nullptr)
+            {
+                positions_->erase(node);
+                index_before(node, before);
+            }
+        }
+    }
+
+    // relinks a hit to the end of the order list in the access order mode
+    NodeBase* touch(NodeBase* node) noexcept
+    {
+        if (access_order_)
+        {
+            relink_before(node, &header_);
+        }
+        return node;
+    }
+
+    iterator touch(iterator it) noexcept
+    {
+        if (it.node_ != &header_)
+        {
+            touch(it.node());
+        }
+        return it;
+    }
+
+    // keep is the node just linked, which is never the victim, even when a hint
+    // put it in front: the caller still has to return an iterator to it
+    void evict_overflow(const Links* keep = nullptr)
+    {
+        while (max_entries_ != 0 && size_ > max_entries_)
+        {
+            Links* victim = header_.next == keep ? keep->next : header_.next;
+            NodeBase* eldest = static_cast<NodeBase*>(victim);
+            if (on_evict_)
+            {
+                on_evict_(eldest->value);
+            }
+            unlink_node(eldest);
+            destroy_node(eldest);
+        }
+    }
+
+    // an empty map gets the bucket count, the load factor and the hash values of rhs,
+    // so the copies are linked without hashing, probing or growing
+    void clone_from(const linked_hash_map& rhs)
+    {
+        using TrivialCopy = std::integral_constant<bool,
+            std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value>;
+
+        max_load_factor_ = rhs.max_load_factor_;
+        incremental_rehash_ = rhs.incremental_rehash_;
+        if (rhs.size_ == 0)
+        {
+            return;
+        }
+        Buckets(rhs.buckets_.size(), nullptr, buckets_.get_allocator()).swap(buckets_);
+        shift_ = rhs.shift_;
+        for (const Links* p = rhs.header_.next; p != &rhs.header_; p = p->next)
+        {
+            const Node* src = static_cast<const Node*>(p);
+            const size_type h = rhs.node_hash(src);
+            append_unique(h, clone_node(src, TrivialCopy()));
+        }
+    }
+
+    // links a node whose key is known to be missing at the end, the buckets must
+    // already have room for it; the caller builds the positional index afterwards
+    void append_unique(size_type h, Node* node) noexcept
+    {
+        store_hash(node, h, CacheHash());
+        link_chain(buckets_[bucket_index(h)], node);
+        link_before(node, &header_);
+        ++size_;
+        add_fingerprint(fingerprint_, h, CacheHash());
+    }
+
+    // the whole node is copied bytewise, the links are overwritten when it is linked
+    Node* clone_node(const Node* src, std::true_type)
+    {
+        Node* node = std::addressof(*NodeAllocTraits::allocate(node_alloc_, 1));
+        std::memcpy(static_cast<void*>(node), static_cast<const void*>(src), sizeof(Node));
+        count_stat(&linked_hash_map_stats::node_allocations);
+        return node;
+    }
+
+    Node* clone_node(const Node* src, std::false_type)
+    {
+        return create_node(src->value);
+    }
+
+    // clears this map and takes the nodes, the bucket array and the functors of rhs,
+    // which is left empty; the allocators must be equal or propagate
+    void move_assign(linked_hash_map& rhs, std::true_type)
+    {
+        clear();
+        rhs.finish_compaction();
+        node_alloc_ = rhs.node_alloc_;
+        take_buckets(buckets_, rhs.buckets_);
+        take_buckets(old_buckets_, rhs.old_buckets_);
+        old_shift_ = rhs.old_shift_;
+        migrated_ = rhs.migrated_;
+        if (rhs.size_ > 0)
+        {
+            header_ = rhs.header_;
+            fix_header(header_, rhs.header_);
+        }
+        size_ = rhs.size_;
+        fingerprint_ = rhs.fingerprint_;
+        shift_ = rhs.shift_;
+        rhs.header_.prev = rhs.header_.next = &rhs.header_;
+        rhs.size_ = 0;
+        rhs.fingerprint_ = 0;
+        rhs.shift_ = 0;
+        positions_ = std::move(rhs.positions_);
+        // copied, rhs must still be able to hash
+        max_load_factor_ = rhs.max_load_factor_;
+        incremental_rehash_ = rhs.incremental_rehash_;
+        hash_ = rhs.hash_;
+        eq_ = rhs.eq_;
+        copy_order_policy(rhs);
+    }
+
+    static void take_buckets(Buckets& to, Buckets& from)
+    {
+        const NodeBase* const* old = from.data();
+        to = std::move(from);
+        from.clear();
+        if (to.data() != old)
+        {
+            // the bucket allocator copied the slots, the chain heads still point at the old ones
+            for (NodeBase*& head : to)
+            {
+                if (head != nullptr)
+                {
+                    head->pchain = &head;
+                }
+            }
+        }
+    }
+
+    void move_assign(linked_hash_map& rhs, std::false_type)
+    {
+        if (node_alloc_ == rhs.node_alloc_)
+        {
+            move_assign(rhs, std::true_type());
+            return;
+        }
+        clear();
+        max_load_factor_ = rhs.max_load_factor_;
+        incremental_rehash_ = rhs.incremental_rehash_;
+        hash_ = rhs.hash_;
+        eq_ = rhs.eq_;
+        copy_order_policy(rhs);
+        positional_index(rhs.positional_index());
+        move_elements(rhs);
+    }
+
+    // for unequal allocators: new nodes here, rhs is cleared
+    void move_elements(linked_hash_map& rhs)
+    {
+        reserve(rhs.size());
+        for (Links* p = rhs.header_.next; p != &rhs.header_; p = p->next)
+        {
+            NodeBase* node = static_cast<NodeBase*>(p);
+            move_element(rhs.node_hash(node), node, IsSet());
+        }
+        rhs.clear();
+    }
+
+    void move_element(size_type h, NodeBase* node, std::false_type)
+    {
+        try_emplace_impl(&header_, h, node->value.first, std::move(node->value.second));
+    }
+
+    void move_element(size_type h, NodeBase* node, std::true_type)
+    {
+        try_emplace_impl(&header_, h, node->value);
+    }
+
+    void copy_order_policy(const linked_hash_map& rhs)
+    {
+        access_order_ = rhs.access_order_;
+        max_entries_ = rhs.max_entries_;
+        on_evict_ = rhs.on_evict_;
+    }
+
+    static void link_chain(NodeBase*& head, NodeBase* node) noexcept
+    {
+        node->chain = head;
+        node->pchain = &head;
+        if (head != nullptr)
+        {
+            head->pchain = &node->chain;
+        }
+        head = node;
+    }
+
+    // O(1), neither compares nor hashes the key
+    void unlink_node(NodeBase* node) noexcept
+    {
+        remove_fingerprint(node, CacheHash());
+        if (positions_ != nullptr)
+        {
+            positions_->erase(node);
+        }
+        if (node == compact_cursor_)
+        {
+            compact_cursor_ = node->next;
+        }
+        *node->pchain = node->chain;
+        if (node->chain != nullptr)
+        {
+            node->chain->pchain = node->pchain;
+        }
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        --size_;
+    }
+
+    void remove_fingerprint(const NodeBase* node, std::true_type) noexcept
+    {
+        fingerprint_ -= detail::fingerprint_mix(static_cast<const Node*>(node)->hash);
+    }
+
+    void remove_fingerprint(const NodeBase*, std::false_type) noexcept {}
+
+    // the nodes, the buckets and the counters, but not the functors
+    void swap_nodes(linked_hash_map& rhs) noexcept
+    {
+        using std::swap;
+        swap(header_, rhs.header_);
+        fix_header(header_, rhs.header_);
+        fix_header(rhs.header_, header_);
+        swap(buckets_, rhs.buckets_);
+        swap(size_, rhs.size_);
+        swap(fingerprint_, rhs.fingerprint_);
+        swap(shift_, rhs.shift_);
+        swap(old_buckets_, rhs.old_buckets_);
+        swap(old_shift_, rhs.old_shift_);
+        swap(migrated_, rhs.migrated_);
+        swap(compact_cursor_, rhs.compact_cursor_);
+        swap(compact_freed_, rhs.compact_freed_);
+        positions_.swap(rhs.positions_);
+        // a pass that has reached the end points at the other sentinel
+        if (compact_cursor_ == &rhs.header_)
+        {
+            compact_cursor_ = &header_;
+        }
+        if (rhs.compact_cursor_ == &header_)
+        {
+            rhs.compact_cursor_ = &rhs.header_;
+        }
+    }
+
+    void swap_allocator(linked_hash_map& rhs, std::true_type) noexcept
+    {
+        using std::swap;
+        swap(node_alloc_, rhs.node_alloc_);
+    }
+
+    void swap_allocator(linked_hash_map&, std::false_type) noexcept {}
+
+    // after swapping two sentinels, make the neighbours point at the new one
+    static void fix_header(Links& header, Links& old) noexcept
+    {
+        if (header.next == &old)
+        {
+            header.prev = header.next = &header;
+        }
+        else
+        {
+            header.next->prev = &header;
+            header.prev->next = &header;
+        }
     }
 
 }; // class linked_hash_map
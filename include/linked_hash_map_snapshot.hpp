@@ -0,0 +1,465 @@
+/*
+ * linked_hash_map_snapshot
+ *
+ * A versioned binary format for ppstd::linked_hash_map: a header with the
+ * bucket count, then the elements in their order, each one after the hash
+ * value of its key. Loading sizes the bucket array once and links the nodes
+ * with the recorded hash values, so no key is hashed again.
+ *
+ * - write_snapshot / read_snapshot stream any Key and T that have a
+ *   ppstd::snapshot_codec. Codecs are provided for the trivially copyable
+ *   types, std::basic_string and std::vector; specialize it for your own types.
+ * - load_snapshot builds a map straight from a buffer when Key and T are
+ *   trivially copyable: all the records have one size and each is copied into
+ *   its node with memcpy, with no parsing and no probing.
+ *   load_snapshot_file gets that buffer by mmap on POSIX systems.
+ *
+ * The recorded hash values are trusted only if the first one is what the
+ * hasher of the loading map gives (e.g. the same std::hash build); otherwise
+ * every key is hashed again. The byte order is the writer's, and a reader of
+ * the other byte order refuses the snapshot. Only load snapshots you wrote:
+ * load_snapshot does not look for duplicate keys.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_LINKED_HASH_MAP_SNAPSHOT_H_
+#define PPSTD_LINKED_HASH_MAP_SNAPSHOT_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "linked_hash_map.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ppstd
+{
+
+class snapshot_error : public std::runtime_error
+{
+public:
+    explicit snapshot_error(const std::string& what)
+        : std::runtime_error("linked_hash_map snapshot: " + what) {}
+};
+
+
+// static void write(std::ostream&, const T&) and static T read(std::istream&)
+template <class T, class = void>
+struct snapshot_codec;
+
+
+namespace detail
+{
+
+inline std::uint32_t snapshot_version() noexcept { return 1; }
+inline std::uint32_t snapshot_byte_order() noexcept { return 0x01020304; }
+
+// every record is the hash value, then the bytes of the key and of the mapped value
+inline std::uint32_t snapshot_fixed_records() noexcept { return 1; }
+
+struct SnapshotHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t flags;
+    std::uint32_t key_size;
+    std::uint32_t mapped_size;
+    std::uint64_t size;
+    std::uint64_t bucket_count;
+};
+
+static_assert(sizeof(SnapshotHeader) == 40, "the snapshot header must not have padding");
+
+inline void write_bytes(std::ostream& os, const void* p, std::size_t n)
+{
+    os.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+    if (!os)
+    {
+        throw snapshot_error("write failed");
+    }
+}
+
+inline void read_bytes(std::istream& is, void* p, std::size_t n)
+{
+    is.read(static_cast<char*>(p), static_cast<std::streamsize>(n));
+    if (static_cast<std::size_t>(is.gcount()) != n)
+    {
+        throw snapshot_error("unexpected end of the snapshot");
+    }
+}
+
+inline void check_header(const SnapshotHeader& header)
+{
+    if (std::memcmp(header.magic, "PLHM", 4) != 0)
+    {
+        throw snapshot_error("not a snapshot");
+    }
+    if (header.version != snapshot_version())
+    {
+        throw snapshot_error("unsupported version " + std::to_string(header.version));
+    }
+    if (header.byte_order != snapshot_byte_order())
+    {
+        throw snapshot_error("written with the other byte order");
+    }
+    if ((header.bucket_count & (header.bucket_count - 1)) != 0)
+    {
+        throw snapshot_error("corrupt bucket count");
+    }
+}
+
+template <class T>
+void write_vector(std::ostream& os, const T* data, std::size_t n, std::true_type)
+{
+    write_bytes(os, data, n * sizeof(T));
+}
+
+template <class T>
+void write_vector(std::ostream& os, const T* data, std::size_t n, std::false_type)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        snapshot_codec<T>::write(os, data[i]);
+    }
+}
+
+template <class T, class A>
+void read_vector(std::istream& is, std::vector<T, A>& v, std::size_t n, std::true_type)
+{
+    v.resize(n);
+    if (n > 0)
+    {
+        read_bytes(is, v.data(), n * sizeof(T));
+    }
+}
+
+template <class T, class A>
+void read_vector(std::istream& is, std::vector<T, A>& v, std::size_t n, std::false_type)
+{
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        v.push_back(snapshot_codec<T>::read(is));
+    }
+}
+
+} // namespace detail
+
+
+template <class T>
+struct snapshot_codec<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+{
+    static void write(std::ostream& os, const T& value)
+    {
+        detail::write_bytes(os, std::addressof(value), sizeof(T));
+    }
+
+    static T read(std::istream& is)
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type buf;
+        detail::read_bytes(is, &buf, sizeof(T));
+        return *reinterpret_cast<T*>(&buf);
+    }
+};
+
+template <class C, class Traits, class A>
+struct snapshot_codec<std::basic_string<C, Traits, A>>
+{
+    static void write(std::ostream& os, const std::basic_string<C, Traits, A>& s)
+    {
+        snapshot_codec<std::uint64_t>::write(os, s.size());
+        detail::write_bytes(os, s.data(), s.size() * sizeof(C));
+    }
+
+    static std::basic_string<C, Traits, A> read(std::istream& is)
+    {
+        const std::uint64_t n = snapshot_codec<std::uint64_t>::read(is);
+        std::basic_string<C, Traits, A> s(static_cast<std::size_t>(n), C());
+        if (n > 0)
+        {
+            detail::read_bytes(is, &s[0], s.size() * sizeof(C));
+        }
+        return s;
+    }
+};
+
+template <class T, class A>
+struct snapshot_codec<std::vector<T, A>>
+{
+    static void write(std::ostream& os, const std::vector<T, A>& v)
+    {
+        snapshot_codec<std::uint64_t>::write(os, v.size());
+        detail::write_vector(os, v.data(), v.size(), std::is_trivially_copyable<T>());
+    }
+
+    static std::vector<T, A> read(std::istream& is)
+    {
+        const std::uint64_t n = snapshot_codec<std::uint64_t>::read(is);
+        std::vector<T, A> v;
+        detail::read_vector(is, v, static_cast<std::size_t>(n), std::is_trivially_copyable<T>());
+        return v;
+    }
+};
+
+
+namespace detail
+{
+
+template <class Map>
+struct SnapshotAccess;
+
+template <class Key, class T, class Hash, class Pred, class Alloc>
+struct SnapshotAccess<linked_hash_map<Key, T, Hash, Pred, Alloc>>
+{
+    using Map = linked_hash_map<Key, T, Hash, Pred, Alloc>;
+    using Node = typename Map::Node;
+    using NodeBase = typename Map::NodeBase;
+    using Links = typename Map::Links;
+    using size_type = typename Map::size_type;
+    using FixedRecords = std::integral_constant<bool,
+        std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value>;
+
+    static void write(std::ostream& os, const Map& map)
+    {
+        SnapshotHeader header;
+        std::memcpy(header.magic, "PLHM", 4);
+        header.version = snapshot_version();
+        header.byte_order = snapshot_byte_order();
+        header.flags = FixedRecords::value ? snapshot_fixed_records() : 0;
+        header.key_size = sizeof(Key);
+        header.mapped_size = sizeof(T);
+        header.size = map.size();
+        header.bucket_count = map.bucket_count();
+        write_bytes(os, &header, sizeof(header));
+
+        for (const Links* p = map.header_.next; p != &map.header_; p = p->next)
+        {
+            const NodeBase* node = static_cast<const NodeBase*>(p);
+            snapshot_codec<std::uint64_t>::write(os, map.node_hash(node));
+            snapshot_codec<Key>::write(os, node->value.first);
+            snapshot_codec<T>::write(os, node->value.second);
+        }
+    }
+
+    static void read(std::istream& is, Map& map)
+    {
+        SnapshotHeader header;
+        read_bytes(is, &header, sizeof(header));
+        check_header(header);
+        if ((header.flags & snapshot_fixed_records()) != 0 &&
+            (header.key_size != sizeof(Key) || header.mapped_size != sizeof(T)))
+        {
+            throw snapshot_error("the records do not match Key and T");
+        }
+
+        map.clear();
+        prepare(map, header);
+        try
+        {
+            bool trusted = true;
+            for (std::uint64_t i = 0; i < header.size; ++i)
+            {
+                size_type h = static_cast<size_type>(snapshot_codec<std::uint64_t>::read(is));
+                Key k = snapshot_codec<Key>::read(is);
+                T obj = snapshot_codec<T>::read(is);
+                h = checked_hash(map, k, h, i, trusted);
+                map.try_emplace_hashed(h, std::move(k), std::move(obj));
+            }
+        }
+        catch (...)
+        {
+            map.clear();
+            throw;
+        }
+    }
+
+    static void load(const void* data, std::size_t bytes, Map& map)
+    {
+        static_assert(FixedRecords::value,
+            "load_snapshot needs trivially copyable Key and T, use read_snapshot");
+
+        SnapshotHeader header;
+        if (bytes < sizeof(header))
+        {
+            throw snapshot_error("unexpected end of the snapshot");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        check_header(header);
+        if ((header.flags & snapshot_fixed_records()) == 0 ||
+            header.key_size != sizeof(Key) || header.mapped_size != sizeof(T))
+        {
+            throw snapshot_error("the records do not match Key and T");
+        }
+        const std::size_t record = sizeof(std::uint64_t) + sizeof(Key) + sizeof(T);
+        if ((bytes - sizeof(header)) / record < header.size)
+        {
+            throw snapshot_error("unexpected end of the snapshot");
+        }
+
+        map.clear();
+        prepare(map, header);
+        const char* p = static_cast<const char*>(data) + sizeof(header);
+        try
+        {
+            bool trusted = true;
+            for (std::uint64_t i = 0; i < header.size; ++i, p += record)
+            {
+                std::uint64_t stored;
+                std::memcpy(&stored, p, sizeof(stored));
+                Node* node = std::addressof(*Map::NodeAllocTraits::allocate(map.node_alloc_, 1));
+                std::memcpy(static_cast<void*>(const_cast<Key*>(std::addressof(node->value.first))),
+                    p + sizeof(stored), sizeof(Key));
+                std::memcpy(static_cast<void*>(std::addressof(node->value.second)),
+                    p + sizeof(stored) + sizeof(Key), sizeof(T));
+                map.count_stat(&linked_hash_map_stats::node_allocations);
+                size_type h;
+                try
+                {
+                    h = checked_hash(map, node->value.first, static_cast<size_type>(stored), i, trusted);
+                }
+                catch (...)
+                {
+                    Map::NodeAllocTraits::deallocate(map.node_alloc_, node, 1);
+                    throw;
+                }
+                map.append_unique(h, node);
+            }
+            if (map.positions_ != nullptr)
+            {
+                map.positions_->build(&map.header_);
+            }
+        }
+        catch (...)
+        {
+            map.clear();
+            throw;
+        }
+        map.evict_overflow();
+    }
+
+    // the recorded bucket count, unless the load factor of map needs more
+    static void prepare(Map& map, const SnapshotHeader& header)
+    {
+        map.rehash(std::max(static_cast<size_type>(header.bucket_count),
+            static_cast<size_type>(std::ceil(header.size / map.max_load_factor()))));
+    }
+
+    // the first key decides whether the recorded hash values can be used
+    template <class K>
+    static size_type checked_hash(const Map& map, const K& k, size_type stored,
+        std::uint64_t i, bool& trusted)
+    {
+        if (i == 0)
+        {
+            const size_type h = map.hash_key(k);
+            trusted = h == stored;
+            return h;
+        }
+        return trusted ? stored : map.hash_key(k);
+    }
+}; // struct SnapshotAccess
+
+} // namespace detail
+
+
+template <class Key, class T, class Hash, class Pred, class Alloc>
+void write_snapshot(std::ostream& os, const linked_hash_map<Key, T, Hash, Pred, Alloc>& map)
+{
+    detail::SnapshotAccess<linked_hash_map<Key, T, Hash, Pred, Alloc>>::write(os, map);
+}
+
+// replaces the elements of map; map is left empty if the snapshot is bad
+template <class Key, class T, class Hash, class Pred, class Alloc>
+void read_snapshot(std::istream& is, linked_hash_map<Key, T, Hash, Pred, Alloc>& map)
+{
+    detail::SnapshotAccess<linked_hash_map<Key, T, Hash, Pred, Alloc>>::read(is, map);
+}
+
+// the buffer is only read during the call, it may be unaligned
+template <class Key, class T, class Hash, class Pred, class Alloc>
+void load_snapshot(const void* data, std::size_t size,
+    linked_hash_map<Key, T, Hash, Pred, Alloc>& map)
+{
+    detail::SnapshotAccess<linked_hash_map<Key, T, Hash, Pred, Alloc>>::load(data, size, map);
+}
+
+template <class Key, class T, class Hash, class Pred, class Alloc>
+void save_snapshot_file(const std::string& path,
+    const linked_hash_map<Key, T, Hash, Pred, Alloc>& map)
+{
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os)
+    {
+        throw snapshot_error("cannot open " + path);
+    }
+    write_snapshot(os, map);
+    os.flush();
+    if (!os)
+    {
+        throw snapshot_error("write failed");
+    }
+}
+
+template <class Key, class T, class Hash, class Pred, class Alloc>
+void load_snapshot_file(const std::string& path, linked_hash_map<Key, T, Hash, Pred, Alloc>& map)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw snapshot_error("cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(detail::SnapshotHeader)))
+    {
+        ::close(fd);
+        throw snapshot_error("unexpected end of the snapshot");
+    }
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw snapshot_error("cannot map " + path);
+    }
+    try
+    {
+        load_snapshot(data, size, map);
+    }
+    catch (...)
+    {
+        ::munmap(data, size);
+        throw;
+    }
+    ::munmap(data, size);
+#else
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+    {
+        throw snapshot_error("cannot open " + path);
+    }
+    std::vector<char> buf((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    load_snapshot(buf.data(), buf.size(), map);
+#endif
+}
+
+} // namespace ppstd
+
+#endif // PPSTD_LINKED_HASH_MAP_SNAPSHOT_H_
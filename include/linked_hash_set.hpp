@@ -0,0 +1,251 @@
+/*
+ * linked_hash_set
+ *
+ * A hash set that preserves the insertion order of its keys, similar to
+ * Java's java.util.LinkedHashSet, e.g. for removing duplicates in order.
+ *
+ * It is the node engine of ppstd::linked_hash_map with nodes that hold
+ * only the key: the order links, the bucket chain links, the cached hash
+ * value if cache_hash_code says so, and the key. There is no mapped value
+ * and no padding for one, and a lookup reads the key straight from the node.
+ *
+ * The keys are const, so iterator and const_iterator both read only.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_LINKED_HASH_SET_H_
+#define PPSTD_LINKED_HASH_SET_H_
+
+#include "linked_hash_map.hpp"
+
+namespace ppstd
+{
+
+template <class Key, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>,
+    class Alloc = std::allocator<Key>>
+class linked_hash_set
+{
+private:
+    using Map = linked_hash_map<Key, detail::KeyOnly, Hash, Pred, Alloc>;
+
+    Map map_;
+
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using allocator_type = Alloc;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = typename Map::const_iterator;
+    using const_iterator = typename Map::const_iterator;
+    using reverse_iterator = typename Map::const_reverse_iterator;
+    using const_reverse_iterator = typename Map::const_reverse_iterator;
+
+    using eviction_callback_type = std::function<void(const key_type&)>;
+
+
+    linked_hash_set() {}
+
+    explicit linked_hash_set(size_type n, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
+        : map_(n, hf, eql, a) {}
+
+    explicit linked_hash_set(const allocator_type& a) : map_(a) {}
+
+    template <class InputIterator>
+    linked_hash_set(InputIterator first, InputIterator last,
+        size_type n = 0, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal(), const allocator_type& a = allocator_type())
+        : map_(n, hf, eql, a)
+    {
+        insert(first, last);
+    }
+
+    linked_hash_set(std::initializer_list<value_type> ilist, size_type n = 0,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal(),
+        const allocator_type& a = allocator_type())
+        : map_(n, hf, eql, a)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    linked_hash_set& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+
+    allocator_type get_allocator() const noexcept { return map_.get_allocator(); }
+
+
+    bool empty() const noexcept { return map_.empty(); }
+    size_type size() const noexcept { return map_.size(); }
+    size_type max_size() const noexcept { return map_.max_size(); }
+
+
+    const_iterator begin() const noexcept { return map_.begin(); }
+    const_iterator end() const noexcept { return map_.end(); }
+    const_iterator cbegin() const noexcept { return map_.cbegin(); }
+    const_iterator cend() const noexcept { return map_.cend(); }
+    const_reverse_iterator rbegin() const noexcept { return map_.rbegin(); }
+    const_reverse_iterator rend() const noexcept { return map_.rend(); }
+    const_reverse_iterator crbegin() const noexcept { return map_.crbegin(); }
+    const_reverse_iterator crend() const noexcept { return map_.crend(); }
+
+
+    // a key already there keeps its place, as with linked_hash_map
+    std::pair<iterator, bool> insert(const value_type& k)
+    {
+        std::pair<typename Map::iterator, bool> res = map_.try_emplace(k);
+        return std::pair<iterator, bool>{res.first, res.second};
+    }
+
+    std::pair<iterator, bool> insert(value_type&& k)
+    {
+        std::pair<typename Map::iterator, bool> res = map_.try_emplace(std::move(k));
+        return std::pair<iterator, bool>{res.first, res.second};
+    }
+
+    // a new key is linked in front of hint
+    iterator insert(const_iterator hint, const value_type& k) { return map_.try_emplace(hint, k); }
+    iterator insert(const_iterator hint, value_type&& k) { return map_.try_emplace(hint, std::move(k)); }
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        return insert(hint, value_type(std::forward<Args>(args)...));
+    }
+
+    // h must be hash_function()(k)
+    std::pair<iterator, bool> insert_hashed(size_type h, const value_type& k)
+    {
+        std::pair<typename Map::iterator, bool> res = map_.try_emplace_hashed(h, k);
+        return std::pair<iterator, bool>{res.first, res.second};
+    }
+
+
+    void move_to_back(const_iterator it) noexcept { map_.move_to_back(it); }
+    void move_to_front(const_iterator it) noexcept { map_.move_to_front(it); }
+    void move_before(const_iterator pos, const_iterator it) noexcept { map_.move_before(pos, it); }
+
+
+    iterator erase(const_iterator position) { return map_.erase(position); }
+    iterator erase(const_iterator first, const_iterator last) { return map_.erase(first, last); }
+    size_type erase(const key_type& k) { return map_.erase(k); }
+
+    void clear() noexcept { map_.clear(); }
+
+    void swap(linked_hash_set& rhs) noexcept { map_.swap(rhs.map_); }
+
+
+    // the access order mode and the bounded size of linked_hash_map
+    bool access_order() const noexcept { return map_.access_order(); }
+    void access_order(bool enabled) noexcept { map_.access_order(enabled); }
+
+    size_type max_entries() const noexcept { return map_.max_entries(); }
+    void max_entries(size_type n) { map_.max_entries(n); }
+
+    void eviction_callback(eviction_callback_type fn) { map_.eviction_callback(std::move(fn)); }
+
+
+    // the non-const find() is a hit for the access order mode
+    iterator find(const key_type& k) { return map_.find(k); }
+    const_iterator find(const key_type& k) const { return map_.find(k); }
+
+    size_type count(const key_type& k) const { return map_.count(k); }
+    bool contains(const key_type& k) const { return map_.contains(k); }
+
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator contains_many(ForwardIterator first, ForwardIterator last, OutputIterator out) const
+    {
+        return map_.contains_many(first, last, out);
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return map_.equal_range(k);
+    }
+
+
+    hasher hash_function() const { return map_.hash_function(); }
+    key_equal key_eq() const { return map_.key_eq(); }
+
+    linked_hash_map_stats stats() const noexcept { return map_.stats(); }
+    linked_hash_map_memory memory_usage() const noexcept { return map_.memory_usage(); }
+    static constexpr size_type node_overhead_bytes() { return Map::node_overhead_bytes(); }
+
+
+    size_type bucket_count() const noexcept { return map_.bucket_count(); }
+    size_type max_bucket_count() const noexcept { return map_.max_bucket_count(); }
+    size_type bucket_size(size_type n) const { return map_.bucket_size(n); }
+    size_type bucket(const key_type& k) const { return map_.bucket(k); }
+
+    float load_factor() const noexcept { return map_.load_factor(); }
+    float max_load_factor() const noexcept { return map_.max_load_factor(); }
+    void max_load_factor(float z) { map_.max_load_factor(z); }
+
+    void rehash(size_type n) { map_.rehash(n); }
+    void reserve(size_type n) { map_.reserve(n); }
+    void shrink_to_fit() { map_.shrink_to_fit(); }
+
+
+    // the key fingerprint of linked_hash_map
+    std::uint64_t key_fingerprint() const { return map_.key_fingerprint(); }
+
+    // the same keys in the same order
+    friend bool operator==(const linked_hash_set& lhs, const linked_hash_set& rhs)
+    {
+        return lhs.map_ == rhs.map_;
+    }
+
+    friend bool operator!=(const linked_hash_set& lhs, const linked_hash_set& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    // the same keys in any order
+    friend bool equal_unordered(const linked_hash_set& lhs, const linked_hash_set& rhs)
+    {
+        return equal_unordered(lhs.map_, rhs.map_);
+    }
+
+    friend void swap(linked_hash_set& lhs, linked_hash_set& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+}; // class linked_hash_set
+
+} // namespace ppstd
+
+#endif // PPSTD_LINKED_HASH_SET_H_
@@ -0,0 +1,137 @@
+/*
+ * parallel_for_each
+ *
+ * Scans a ppstd::linked_hash_map or ppstd::dense_linked_hash_map with several
+ * threads. The map is cut by its chunks(k) into contiguous sub-ranges of its
+ * order, and the threads take the chunks one at a time. Every element is seen
+ * exactly once, the elements of one chunk in their order by one thread; the
+ * chunks themselves run in no particular order.
+ *
+ * The chunks are cut on the calling thread before any worker starts. That is
+ * O(k) for a dense_linked_hash_map and O(k log n) for a linked_hash_map with
+ * its positional_index(true), but a plain linked_hash_map walks its whole
+ * order once, a serial O(n) step that bounds the speedup of a cheap fn.
+ *
+ * The map must not be modified during the scan, and fn is called from
+ * several threads at once.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_PARALLEL_FOR_EACH_H_
+#define PPSTD_PARALLEL_FOR_EACH_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppstd
+{
+
+struct parallel_policy
+{
+    // 0 means one thread per hardware thread
+    unsigned threads;
+    // more chunks than threads even out chunks of uneven cost
+    std::size_t chunks_per_thread;
+
+    explicit parallel_policy(unsigned thread_count = 0, std::size_t chunk_count_per_thread = 4)
+        : threads{ thread_count }, chunks_per_thread{ std::max<std::size_t>(chunk_count_per_thread, 1) } {}
+
+    unsigned thread_count() const noexcept
+    {
+        return threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    }
+};
+
+
+namespace detail
+{
+
+// the first exception thrown by fn stops the workers and is rethrown
+template <class Ranges, class F>
+void run_chunks(unsigned thread_count, const Ranges& ranges, F& fn)
+{
+    std::atomic<std::size_t> next{ 0 };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto work = [&]()
+    {
+        for (std::size_t i = next++; i < ranges.size(); i = next++)
+        {
+            try
+            {
+                fn(ranges[i].first, ranges[i].second, i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                next = ranges.size();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    try
+    {
+        for (unsigned i = 1; i < thread_count; ++i)
+        {
+            workers.emplace_back(work);
+        }
+    }
+    catch (...)
+    {
+        // the thread could not start, whoever started finishes the work
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace detail
+
+
+// calls fn(first, last, chunk_index) for each chunk, e.g. to fold each chunk
+// into its own slot of a vector of partial results
+template <class Map, class F>
+void parallel_for_each_chunk(const parallel_policy& policy, Map& map, F&& fn)
+{
+    const unsigned thread_count = policy.thread_count();
+    const auto ranges = map.chunks(thread_count * policy.chunks_per_thread);
+    detail::run_chunks(std::min<std::size_t>(thread_count, ranges.size()), ranges, fn);
+}
+
+// calls fn(element) for each element, fn gets a const reference for a const map
+template <class Map, class F>
+void parallel_for_each(const parallel_policy& policy, Map& map, F&& fn)
+{
+    const auto body = [&fn](decltype(map.begin()) first, decltype(map.begin()) last, std::size_t)
+    {
+        for (; first != last; ++first)
+        {
+            fn(*first);
+        }
+    };
+    parallel_for_each_chunk(policy, map, body);
+}
+
+} // namespace ppstd
+
+#endif // PPSTD_PARALLEL_FOR_EACH_H_
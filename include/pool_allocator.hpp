@@ -0,0 +1,320 @@
+/*
+ * pool_allocator
+ *
+ * Allocators for the node based containers of ppstd,
+ * e.g. ppstd::linked_hash_map<Key, T, Hash, Pred, ppstd::pool_allocator<...>>.
+ *
+ * - ppstd::node_pool hands out fixed-size blocks from big chunks
+ *   and recycles the freed blocks; ppstd::pool_allocator uses it.
+ * - ppstd::arena is a monotonic buffer that never frees single blocks,
+ *   everything is released at once when the arena is destroyed;
+ *   ppstd::arena_allocator uses it.
+ *
+ * A container rebinds its allocator to its node type, so all the single
+ * object allocations of a map have exactly one size, the node size,
+ * and they come from one free list. Arrays such as the bucket array
+ * are forwarded to the global operator new by node_pool.
+ *
+ * The pools and arenas are not thread-safe and are not owned by the
+ * allocators: give each map (or each thread) its own one, and keep it
+ * alive longer than the containers using it.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_POOL_ALLOCATOR_H_
+#define PPSTD_POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace ppstd
+{
+
+namespace detail
+{
+
+inline std::size_t align_up(std::size_t n, std::size_t align) noexcept
+{
+    return (n + align - 1) / align * align;
+}
+
+} // namespace detail
+
+
+class node_pool
+{
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct FreeList
+    {
+        std::size_t block_size;
+        FreeBlock* head;
+    };
+
+    // one list per block size, a map usually needs only one
+    std::vector<FreeList> lists_;
+    std::vector<void*> chunks_;
+    std::size_t blocks_per_chunk_;
+
+public:
+    explicit node_pool(std::size_t blocks_per_chunk = 256)
+        : blocks_per_chunk_{ blocks_per_chunk > 0 ? blocks_per_chunk : 1 } {}
+
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    ~node_pool() { release(); }
+
+    void* allocate(std::size_t size)
+    {
+        FreeList& list = list_for(block_size_for(size));
+        if (list.head == nullptr)
+        {
+            refill(list);
+        }
+        FreeBlock* block = list.head;
+        list.head = block->next;
+        return block;
+    }
+
+    void deallocate(void* p, std::size_t size) noexcept
+    {
+        FreeList& list = list_for_existing(block_size_for(size));
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = list.head;
+        list.head = block;
+    }
+
+    // frees every chunk, all the blocks handed out become invalid
+    void release() noexcept
+    {
+        for (void* chunk : chunks_)
+        {
+            ::operator delete(chunk);
+        }
+        chunks_.clear();
+        lists_.clear();
+    }
+
+private:
+    // no padding up to max_align_t: a size is a multiple of its type's alignment,
+    // so the blocks laid out back to back in a chunk stay aligned
+    static std::size_t block_size_for(std::size_t size) noexcept
+    {
+        return detail::align_up(size < sizeof(FreeBlock) ? sizeof(FreeBlock) : size,
+            alignof(FreeBlock));
+    }
+
+    FreeList& list_for(std::size_t block_size)
+    {
+        for (FreeList& list : lists_)
+        {
+            if (list.block_size == block_size)
+            {
+                return list;
+            }
+        }
+        lists_.push_back(FreeList{ block_size, nullptr });
+        return lists_.back();
+    }
+
+    FreeList& list_for_existing(std::size_t block_size) noexcept
+    {
+        FreeList* list = lists_.data();
+        while (list->block_size != block_size)
+        {
+            ++list;
+        }
+        return *list;
+    }
+
+    void refill(FreeList& list)
+    {
+        chunks_.reserve(chunks_.size() + 1);
+        char* chunk = static_cast<char*>(::operator new(list.block_size * blocks_per_chunk_));
+        chunks_.push_back(chunk);
+        for (std::size_t i = blocks_per_chunk_; i > 0; --i)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * list.block_size);
+            block->next = list.head;
+            list.head = block;
+        }
+    }
+}; // class node_pool
+
+
+class arena
+{
+private:
+    std::vector<void*> chunks_;
+    char* cur_;
+    std::size_t left_;
+    std::size_t chunk_size_;
+
+public:
+    explicit arena(std::size_t chunk_size = 64 * 1024)
+        : cur_{ nullptr }, left_{ 0 }, chunk_size_{ chunk_size > 0 ? chunk_size : 1 } {}
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() { release(); }
+
+    void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t))
+    {
+        std::size_t pad = detail::align_up(reinterpret_cast<std::size_t>(cur_), align) -
+            reinterpret_cast<std::size_t>(cur_);
+        if (cur_ == nullptr || pad + size > left_)
+        {
+            // big requests get a chunk of their own
+            const std::size_t n = size + align > chunk_size_ ? size + align : chunk_size_;
+            chunks_.reserve(chunks_.size() + 1);
+            cur_ = static_cast<char*>(::operator new(n));
+            chunks_.push_back(cur_);
+            left_ = n;
+            pad = detail::align_up(reinterpret_cast<std::size_t>(cur_), align) -
+                reinterpret_cast<std::size_t>(cur_);
+        }
+        void* p = cur_ + pad;
+        cur_ += pad + size;
+        left_ -= pad + size;
+        return p;
+    }
+
+    // monotonic: single blocks are never reused
+    void deallocate(void*, std::size_t) noexcept {}
+
+    void release() noexcept
+    {
+        for (void* chunk : chunks_)
+        {
+            ::operator delete(chunk);
+        }
+        chunks_.clear();
+        cur_ = nullptr;
+        left_ = 0;
+    }
+}; // class arena
+
+
+template <class T>
+class pool_allocator
+{
+private:
+    template <class> friend class pool_allocator;
+
+    node_pool* pool_;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <class U>
+    struct rebind
+    {
+        using other = pool_allocator<U>;
+    };
+
+    explicit pool_allocator(node_pool& pool) noexcept : pool_{ &pool } {}
+
+    template <class U>
+    pool_allocator(const pool_allocator<U>& rhs) noexcept : pool_{ rhs.pool_ } {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n == 1)
+        {
+            return static_cast<T*>(pool_->allocate(sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (n == 1)
+        {
+            pool_->deallocate(p, sizeof(T));
+        }
+        else
+        {
+            ::operator delete(p);
+        }
+    }
+
+    node_pool& pool() const noexcept { return *pool_; }
+
+    template <class U>
+    friend bool operator==(const pool_allocator& lhs, const pool_allocator<U>& rhs) noexcept
+    {
+        return &lhs.pool() == &rhs.pool();
+    }
+
+    template <class U>
+    friend bool operator!=(const pool_allocator& lhs, const pool_allocator<U>& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+}; // class pool_allocator
+
+
+template <class T>
+class arena_allocator
+{
+private:
+    template <class> friend class arena_allocator;
+
+    arena* arena_;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <class U>
+    struct rebind
+    {
+        using other = arena_allocator<U>;
+    };
+
+    explicit arena_allocator(ppstd::arena& a) noexcept : arena_{ &a } {}
+
+    template <class U>
+    arena_allocator(const arena_allocator<U>& rhs) noexcept : arena_{ rhs.arena_ } {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept { arena_->deallocate(p, n * sizeof(T)); }
+
+    ppstd::arena& get_arena() const noexcept { return *arena_; }
+
+    template <class U>
+    friend bool operator==(const arena_allocator& lhs, const arena_allocator<U>& rhs) noexcept
+    {
+        return &lhs.get_arena() == &rhs.get_arena();
+    }
+
+    template <class U>
+    friend bool operator!=(const arena_allocator& lhs, const arena_allocator<U>& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+}; // class arena_allocator
+
+} // namespace ppstd
+
+#endif // PPSTD_POOL_ALLOCATOR_H_
@@ -0,0 +1,739 @@
+/*
+ * small_linked_hash_map
+ *
+ * The small size storage of ppstd::linked_hash_map, for the many maps that
+ * hold a handful of elements: up to N key value pairs live inline in the
+ * object, in insertion order, and are found by a linear scan with Pred.
+ * A small map neither allocates nor hashes. Inserting the (N + 1)-th element
+ * moves them all into a ppstd::linked_hash_map, which is used from then on.
+ *
+ * It has a subset of the APIs of ppstd::linked_hash_map: construction,
+ * assignment and swap, forward iteration, size() and empty(), insert, emplace,
+ * try_emplace, insert_or_assign, erase, clear, find, count, contains, at,
+ * operator[], the non-const equal_range, reserve, shrink_to_fit, memory_usage
+ * and ==. Code that uses only those switches between the two by changing the
+ * type. emplace_hint ignores its hint. Reverse iteration, the hinted inserts,
+ * the order operations, node handles, nth and rank, the batched finds, the
+ * bucket interface and max_load_factor, transparent lookup and the access order
+ * mode are only in ppstd::linked_hash_map.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_SMALL_LINKED_HASH_MAP_H_
+#define PPSTD_SMALL_LINKED_HASH_MAP_H_
+
+#include <new>
+#include <tuple>
+
+#include "linked_hash_map.hpp"
+
+namespace ppstd
+{
+
+template <class Key, class T, std::size_t N, class Hash, class Pred>
+class small_linked_hash_map;
+
+namespace detail
+{
+
+// walks the inline slots while the map is small, otherwise the nodes
+template <typename K, typename V, typename LargeIter>
+class SmallIterator
+{
+private:
+    using Pair = typename std::conditional<
+        std::is_const<V>::value,
+        const std::pair<K, typename std::remove_const<V>::type>,
+        std::pair<K, V>
+        >::type;
+
+    template <typename, typename, typename> friend class SmallIterator;
+    template <class, class, std::size_t, class, class> friend class ppstd::small_linked_hash_map;
+
+    // null once the map has moved to the hashed layout
+    Pair* inline_;
+    LargeIter large_;
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::pair<K, typename std::remove_const<V>::type>;
+    using difference_type = std::ptrdiff_t;
+    using reference = Pair&;
+    using pointer = Pair*;
+
+    SmallIterator() : inline_{ nullptr } {}
+    explicit SmallIterator(Pair* const p) : inline_{ p } {}
+    explicit SmallIterator(const LargeIter& it) : inline_{ nullptr }, large_(it) {}
+
+    // iterator -> const_iterator
+    template <typename U, typename LU, typename = typename std::enable_if<
+        std::is_const<V>::value && std::is_same<U, typename std::remove_const<V>::type>::value>::type>
+    SmallIterator(const SmallIterator<K, U, LU>& rhs) : inline_{ rhs.inline_ }, large_(rhs.large_) {}
+
+    SmallIterator& operator++()
+    {
+        if (inline_ != nullptr)
+        {
+            ++inline_;
+        }
+        else
+        {
+            ++large_;
+        }
+        return *this;
+    }
+
+    SmallIterator operator++(int)
+    {
+        SmallIterator orig(*this);
+        ++(*this);
+        return orig;
+    }
+
+    SmallIterator& operator--()
+    {
+        if (inline_ != nullptr)
+        {
+            --inline_;
+        }
+        else
+        {
+            --large_;
+        }
+        return *this;
+    }
+
+    SmallIterator operator--(int)
+    {
+        SmallIterator orig(*this);
+        --(*this);
+        return orig;
+    }
+
+    reference operator*() const { return inline_ != nullptr ? *inline_ : *large_; }
+    pointer operator->() const { return &**this; }
+
+    friend bool operator==(const SmallIterator& lhs, const SmallIterator& rhs)
+    {
+        return lhs.inline_ == rhs.inline_ && lhs.large_ == rhs.large_;
+    }
+
+    friend bool operator!=(const SmallIterator& lhs, const SmallIterator& rhs)
+    {
+        return !(lhs == rhs);
+    }
+}; // class SmallIterator
+
+} // namespace detail
+
+
+template <class Key, class T, std::size_t N = 8, class Hash = std::hash<Key>,
+    class Pred = std::equal_to<Key>>
+class small_linked_hash_map
+{
+    static_assert(N > 0, "small_linked_hash_map needs room for one inline element");
+
+private:
+    using Large = linked_hash_map<Key, T, Hash, Pred>;
+    using Storage = typename std::aligned_storage<
+        sizeof(std::pair<const Key, T>) * N, alignof(std::pair<const Key, T>)>::type;
+    // moved when neither move can throw, otherwise copied
+    using NothrowMove = std::integral_constant<bool,
+        std::is_nothrow_move_constructible<Key>::value &&
+        std::is_nothrow_move_constructible<T>::value>;
+
+    // the first size_ inline elements are alive while the map is small
+    Storage inline_;
+    std::size_t size_;
+    // the hashed layout, used once the map has held more than N elements
+    Large large_;
+    bool spilled_;
+    Pred eq_;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = detail::SmallIterator<const key_type, mapped_type,
+        typename Large::iterator>;
+    using const_iterator = detail::SmallIterator<const key_type, const mapped_type,
+        typename Large::const_iterator>;
+
+
+    small_linked_hash_map()
+        noexcept(
+            std::is_nothrow_default_constructible<hasher>::value &&
+            std::is_nothrow_default_constructible<key_equal>::value)
+        : size_{ 0 }, spilled_{ false } {}
+
+    // more than N elements go to the hashed layout at once
+    explicit small_linked_hash_map(size_type n, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal())
+        : size_{ 0 }, large_(0, hf, eql), spilled_{ false }, eq_(eql)
+    {
+        reserve(n);
+    }
+
+    template <class InputIterator>
+    small_linked_hash_map(InputIterator first, InputIterator last,
+        size_type n = 0, const hasher& hf = hasher(),
+        const key_equal& eql = key_equal()) : small_linked_hash_map(n, hf, eql)
+    {
+        insert(first, last);
+    }
+
+    small_linked_hash_map(const small_linked_hash_map& rhs)
+        : size_{ 0 }, large_(rhs.large_), spilled_{ rhs.spilled_ }, eq_(rhs.eq_)
+    {
+        try
+        {
+            for (; size_ < rhs.size_; ++size_)
+            {
+                ::new (static_cast<void*>(slot(size_))) value_type(*rhs.slot(size_));
+            }
+        }
+        catch (...)
+        {
+            destroy_inline();
+            throw;
+        }
+    }
+
+    small_linked_hash_map(small_linked_hash_map&& rhs)
+        noexcept(NothrowMove::value && std::is_nothrow_move_constructible<Large>::value &&
+            std::is_nothrow_copy_constructible<key_equal>::value)
+        : size_{ 0 }, large_(std::move(rhs.large_)), spilled_{ rhs.spilled_ }, eq_(rhs.eq_)
+    {
+        take_inline(rhs);
+    }
+
+    small_linked_hash_map(std::initializer_list<value_type> ilist, size_type n = 0,
+        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : small_linked_hash_map(n, hf, eql)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    ~small_linked_hash_map() { destroy_inline(); }
+
+    small_linked_hash_map& operator=(const small_linked_hash_map& rhs)
+    {
+        if (this != &rhs)
+        {
+            small_linked_hash_map tmp(rhs);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    small_linked_hash_map& operator=(small_linked_hash_map&& rhs)
+        noexcept(NothrowMove::value && std::is_nothrow_move_assignable<Large>::value &&
+            std::is_nothrow_copy_assignable<key_equal>::value)
+    {
+        if (this != &rhs)
+        {
+            destroy_inline();
+            large_ = std::move(rhs.large_);
+            spilled_ = rhs.spilled_;
+            eq_ = rhs.eq_;
+            take_inline(rhs);
+        }
+        return *this;
+    }
+
+    small_linked_hash_map& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+
+    bool empty() const noexcept { return size() == 0; }
+    size_type size() const noexcept { return spilled_ ? large_.size() : size_; }
+    size_type max_size() const noexcept { return large_.max_size(); }
+
+    // false once the elements have moved to the hashed layout
+    bool is_inline() const noexcept { return !spilled_; }
+    static constexpr size_type inline_capacity() { return N; }
+
+
+    iterator begin() noexcept
+    {
+        return spilled_ ? iterator(large_.begin()) : iterator(slot(0));
+    }
+
+    iterator end() noexcept
+    {
+        return spilled_ ? iterator(large_.end()) : iterator(slot(size_));
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return spilled_ ? const_iterator(large_.begin()) : const_iterator(slot(0));
+    }
+
+    const_iterator end() const noexcept
+    {
+        return spilled_ ? const_iterator(large_.end()) : const_iterator(slot(size_));
+    }
+
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return try_emplace_impl(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace_impl(value.first, std::move(value.second));
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+    {
+        return try_emplace_impl(k, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+    {
+        return try_emplace_impl(std::move(k), std::forward<Args>(args)...);
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+    {
+        return insert_or_assign_impl(k, std::forward<M>(obj));
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj)
+    {
+        return insert_or_assign_impl(std::move(k), std::forward<M>(obj));
+    }
+
+
+    hasher hash_function() const { return large_.hash_function(); }
+    key_equal key_eq() const { return eq_; }
+
+
+    // O(N) while small, the later elements move down one slot
+    iterator erase(const_iterator position)
+    {
+        if (spilled_)
+        {
+            return iterator(large_.erase(position.large_));
+        }
+        const size_type pos = position.inline_ - slot(0);
+        erase_inline(pos);
+        return iterator(slot(pos));
+    }
+
+    iterator erase(iterator position)
+    {
+        return erase(const_iterator(position));
+    }
+
+    size_type erase(const key_type& k)
+    {
+        if (spilled_)
+        {
+            return large_.erase(k);
+        }
+        const size_type pos = find_inline(k);
+        if (pos == npos())
+        {
+            return 0;
+        }
+        erase_inline(pos);
+        return 1;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        if (spilled_)
+        {
+            return iterator(large_.erase(first.large_, last.large_));
+        }
+        const size_type pos = first.inline_ - slot(0);
+        for (size_type n = last.inline_ - first.inline_; n > 0; --n)
+        {
+            erase_inline(pos);
+        }
+        return iterator(slot(pos));
+    }
+
+    // keeps the layout, a cleared hashed map stays hashed
+    void clear() noexcept
+    {
+        if (spilled_)
+        {
+            large_.clear();
+        }
+        else
+        {
+            destroy_inline();
+        }
+    }
+
+    void swap(small_linked_hash_map& rhs)
+        noexcept(std::is_nothrow_move_constructible<small_linked_hash_map>::value &&
+            std::is_nothrow_move_assignable<small_linked_hash_map>::value)
+    {
+        small_linked_hash_map tmp(std::move(rhs));
+        rhs = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+
+    iterator find(const key_type& k)
+    {
+        if (spilled_)
+        {
+            return iterator(large_.find(k));
+        }
+        const size_type pos = find_inline(k);
+        return pos == npos() ? end() : iterator(slot(pos));
+    }
+
+    const_iterator find(const key_type& k) const
+    {
+        if (spilled_)
+        {
+            return const_iterator(large_.find(k));
+        }
+        const size_type pos = find_inline(k);
+        return pos == npos() ? end() : const_iterator(slot(pos));
+    }
+
+    size_type count(const key_type& k) const
+    {
+        return spilled_ ? large_.count(k) : (find_inline(k) == npos() ? 0 : 1);
+    }
+
+    bool contains(const key_type& k) const { return count(k) != 0; }
+
+    std::pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        iterator lower_it = find(k);
+        iterator upper_it = lower_it;
+        if (upper_it != end())
+        {
+            ++upper_it;
+        }
+        return std::pair<iterator, iterator>{lower_it, upper_it};
+    }
+
+
+    mapped_type& operator[](const key_type& k)
+    {
+        return try_emplace_impl(k).first->second;
+    }
+
+    mapped_type& operator[](key_type&& k)
+    {
+        return try_emplace_impl(std::move(k)).first->second;
+    }
+
+
+    mapped_type& at(const key_type& k)
+    {
+        iterator it = find(k);
+        if (it == end())
+        {
+            throw std::out_of_range("small_linked_hash_map::at: key not found");
+        }
+        return it->second;
+    }
+
+    const mapped_type& at(const key_type& k) const
+    {
+        const_iterator it = find(k);
+        if (it == end())
+        {
+            throw std::out_of_range("small_linked_hash_map::at: key not found");
+        }
+        return it->second;
+    }
+
+
+    // the inline elements are part of the object, so a small map reports nothing
+    linked_hash_map_memory memory_usage() const noexcept { return large_.memory_usage(); }
+
+    // room for n elements; more than N moves the map to the hashed layout
+    void reserve(size_type n)
+    {
+        if (n > N && !spilled_)
+        {
+            large_.reserve(n);
+            spill(large_.cend());
+        }
+        else if (spilled_)
+        {
+            large_.reserve(n);
+        }
+    }
+
+    // a hashed map whose elements fit inline again moves them back
+    void shrink_to_fit()
+    {
+        if (!spilled_)
+        {
+            return;
+        }
+        if (large_.size() > N)
+        {
+            large_.shrink_to_fit();
+            return;
+        }
+        try
+        {
+            for (auto it = large_.begin(); it != large_.end(); ++it, ++size_)
+            {
+                relocate(slot(size_), &*it, NothrowMove());
+            }
+        }
+        catch (...)
+        {
+            destroy_inline();
+            throw;
+        }
+        large_.clear();
+        large_.shrink_to_fit();
+        spilled_ = false;
+    }
+
+
+    friend bool operator==(const small_linked_hash_map& lhs, const small_linked_hash_map& rhs)
+    {
+        if (lhs.size() != rhs.size())
+        {
+            return false;
+        }
+
+        for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin(); lhs_it != lhs.end(); ++lhs_it, ++rhs_it)
+        {
+            if (lhs_it->first != rhs_it->first || lhs_it->second != rhs_it->second)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const small_linked_hash_map& lhs, const small_linked_hash_map& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend void swap(small_linked_hash_map& lhs, small_linked_hash_map& rhs)
+        noexcept(noexcept(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+
+private:
+    static constexpr size_type npos() { return static_cast<size_type>(-1); }
+
+    value_type* slot(size_type i) noexcept { return reinterpret_cast<value_type*>(&inline_) + i; }
+
+    const value_type* slot(size_type i) const noexcept
+    {
+        return reinterpret_cast<const value_type*>(&inline_) + i;
+    }
+
+    // no hashing: at most N calls of Pred
+    size_type find_inline(const key_type& k) const
+    {
+        for (size_type i = 0; i < size_; ++i)
+        {
+            if (eq_(slot(i)->first, k))
+            {
+                return i;
+            }
+        }
+        return npos();
+    }
+
+    template <class K, class... Args>
+    std::pair<iterator, bool> try_emplace_impl(K&& k, Args&&... args)
+    {
+        if (!spilled_)
+        {
+            const size_type pos = find_inline(k);
+            if (pos != npos())
+            {
+                return std::pair<iterator, bool>{iterator(slot(pos)), false};
+            }
+            if (size_ < N)
+            {
+                ::new (static_cast<void*>(slot(size_))) value_type(std::piecewise_construct,
+                    std::forward_as_tuple(std::forward<K>(k)),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+                return std::pair<iterator, bool>{iterator(slot(size_++)), true};
+            }
+            // the new element is built first, args may refer to an inline element
+            large_.reserve(N + 1);
+            const typename Large::iterator added =
+                large_.try_emplace(std::forward<K>(k), std::forward<Args>(args)...).first;
+            spill(added);
+            return std::pair<iterator, bool>{iterator(added), true};
+        }
+        const std::pair<typename Large::iterator, bool> res =
+            large_.try_emplace(std::forward<K>(k), std::forward<Args>(args)...);
+        return std::pair<iterator, bool>{iterator(res.first), res.second};
+    }
+
+    // obj is only used once: try_emplace leaves it alone on a hit
+    template <class K, class M>
+    std::pair<iterator, bool> insert_or_assign_impl(K&& k, M&& obj)
+    {
+        std::pair<iterator, bool> res = try_emplace_impl(std::forward<K>(k), std::forward<M>(obj));
+        if (!res.second)
+        {
+            res.first->second = std::forward<M>(obj);
+        }
+        return res;
+    }
+
+    // the inline elements go to large_ in their order before pos, and large_ is used
+    // from then on; if that throws, they stay inline and large_ is emptied
+    void spill(typename Large::const_iterator pos)
+    {
+        try
+        {
+            for (size_type i = 0; i < size_; ++i)
+            {
+                spill_element(pos, *slot(i), NothrowMove());
+            }
+        }
+        catch (...)
+        {
+            large_.clear();
+            throw;
+        }
+        destroy_inline();
+        spilled_ = true;
+    }
+
+    void spill_element(typename Large::const_iterator pos, value_type& v, std::true_type)
+    {
+        large_.try_emplace(pos, std::move(const_cast<key_type&>(v.first)), std::move(v.second));
+    }
+
+    void spill_element(typename Large::const_iterator pos, value_type& v, std::false_type)
+    {
+        large_.try_emplace(pos, v.first, v.second);
+    }
+
+    // the source is destroyed right after, so its key may be moved from
+    static void relocate(value_type* to, value_type* from, std::true_type) noexcept
+    {
+        ::new (static_cast<void*>(to)) value_type(
+            std::move(const_cast<key_type&>(from->first)), std::move(from->second));
+    }
+
+    static void relocate(value_type* to, value_type* from, std::false_type)
+    {
+        ::new (static_cast<void*>(to)) value_type(*from);
+    }
+
+    // if a copy throws, the elements from pos on are lost
+    void erase_inline(size_type pos)
+    {
+        slot(pos)->~value_type();
+        for (; pos + 1 < size_; ++pos)
+        {
+            try
+            {
+                relocate(slot(pos), slot(pos + 1), NothrowMove());
+            }
+            catch (...)
+            {
+                for (size_type i = pos + 1; i < size_; ++i)
+                {
+                    slot(i)->~value_type();
+                }
+                size_ = pos;
+                throw;
+            }
+            slot(pos + 1)->~value_type();
+        }
+        --size_;
+    }
+
+    // the inline elements of rhs, rhs is left empty and small
+    void take_inline(small_linked_hash_map& rhs)
+    {
+        try
+        {
+            for (; size_ < rhs.size_; ++size_)
+            {
+                relocate(slot(size_), rhs.slot(size_), NothrowMove());
+            }
+        }
+        catch (...)
+        {
+            destroy_inline();
+            throw;
+        }
+        rhs.destroy_inline();
+        rhs.spilled_ = false;
+    }
+
+    void destroy_inline() noexcept
+    {
+        for (size_type i = 0; i < size_; ++i)
+        {
+            slot(i)->~value_type();
+        }
+        size_ = 0;
+    }
+
+}; // class small_linked_hash_map
+
+} // namespace ppstd
+
+#endif // PPSTD_SMALL_LINKED_HASH_MAP_H_
@@ -0,0 +1,298 @@
+/*
+ * versioned_linked_hash_map
+ *
+ * A ppstd::linked_hash_map in update order, for replicating a map by its
+ * changes instead of by full snapshots. Every write takes the next number of
+ * one monotonic version counter: a new element is stamped with it, an
+ * assigned one is stamped again and relinked to the end. So the order is
+ * always the version order, and changes_since(v) walks back from the end
+ * only over the elements written after v.
+ *
+ * An erased element leaves a tombstone, its key and the version of the
+ * erase, in a bounded log. When the log is full the oldest tombstone is
+ * dropped, and horizon() tells the oldest version the log still covers; a
+ * follower that is further behind has to start over from a full copy.
+ *
+ * This file is licensed under the MIT license.
+ *
+ */
+
+
+#ifndef PPSTD_VERSIONED_LINKED_HASH_MAP_H_
+#define PPSTD_VERSIONED_LINKED_HASH_MAP_H_
+
+#include <cstdint>
+#include <deque>
+
+#include "linked_hash_map.hpp"
+
+namespace ppstd
+{
+
+// the mapped value of a versioned_linked_hash_map with the version of its last write
+template <typename T>
+struct versioned_value
+{
+    std::uint64_t version;
+    T value;
+
+    template <typename... Args>
+    explicit versioned_value(std::uint64_t v, Args&&... args)
+        : version{ v }, value(std::forward<Args>(args)...) {}
+};
+
+
+namespace detail
+{
+
+constexpr std::size_t tombstone_log_size() { return 4096; }
+
+} // namespace detail
+
+
+template <class Key, class T, class Hash = std::hash<Key>, class Pred = std::equal_to<Key>>
+class versioned_linked_hash_map
+{
+private:
+    using Map = linked_hash_map<Key, versioned_value<T>, Hash, Pred>;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using hasher = Hash;
+    using key_equal = Pred;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = size_t;
+    using version_type = std::uint64_t;
+
+    // the elements as pairs of the key and versioned_value<T>, in version order;
+    // they are read-only, the writes go through the map to be stamped
+    using const_iterator = typename Map::const_iterator;
+    using iterator = const_iterator;
+
+    struct tombstone
+    {
+        key_type key;
+        version_type version;
+    };
+
+    using tombstone_iterator = typename std::deque<tombstone>::const_iterator;
+
+private:
+    Map map_;
+    // in version order, the oldest first
+    std::deque<tombstone> tombstones_;
+    size_type tombstone_capacity_;
+    version_type version_;
+    version_type horizon_;
+
+public:
+    explicit versioned_linked_hash_map(size_type tombstone_capacity = detail::tombstone_log_size(),
+        const hasher& hf = hasher(), const key_equal& eql = key_equal())
+        : map_(0, hf, eql), tombstone_capacity_{ tombstone_capacity }, version_{ 0 }, horizon_{ 0 } {}
+
+
+    bool empty() const noexcept { return map_.empty(); }
+    size_type size() const noexcept { return map_.size(); }
+
+    // the version of the last write, 0 before the first one
+    version_type version() const noexcept { return version_; }
+
+    // changes_since(v) and erased_since(v) are complete for any v >= horizon()
+    version_type horizon() const noexcept { return horizon_; }
+
+    size_type tombstone_capacity() const noexcept { return tombstone_capacity_; }
+
+    void tombstone_capacity(size_type n)
+    {
+        tombstone_capacity_ = n;
+        trim_tombstones();
+    }
+
+
+    const_iterator begin() const noexcept { return map_.begin(); }
+    const_iterator end() const noexcept { return map_.end(); }
+    const_iterator cbegin() const noexcept { return map_.begin(); }
+    const_iterator cend() const noexcept { return map_.end(); }
+
+
+    // the elements written after v, the oldest first
+    std::pair<const_iterator, const_iterator> changes_since(version_type v) const
+    {
+        const_iterator first = map_.end();
+        while (first != map_.begin())
+        {
+            const_iterator prev = first;
+            --prev;
+            if (prev->second.version <= v)
+            {
+                break;
+            }
+            first = prev;
+        }
+        return std::pair<const_iterator, const_iterator>{first, map_.end()};
+    }
+
+    // the keys erased after v, the oldest first. A follower at v applies these,
+    // then changes_since(v), and is at version(); a key erased and inserted again
+    // is in both, and the change wins
+    std::pair<tombstone_iterator, tombstone_iterator> erased_since(version_type v) const
+    {
+        tombstone_iterator first = tombstones_.end();
+        while (first != tombstones_.begin() && (first - 1)->version > v)
+        {
+            --first;
+        }
+        return std::pair<tombstone_iterator, tombstone_iterator>{first, tombstones_.end()};
+    }
+
+
+    std::pair<const_iterator, bool> insert(const value_type& value)
+    {
+        return try_emplace(value.first, value.second);
+    }
+
+    std::pair<const_iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    // a hit is no write, it keeps its version and place
+    template <class... Args>
+    std::pair<const_iterator, bool> try_emplace(const key_type& k, Args&&... args)
+    {
+        std::pair<typename Map::iterator, bool> res =
+            map_.try_emplace(k, version_ + 1, std::forward<Args>(args)...);
+        if (res.second)
+        {
+            ++version_;
+        }
+        return std::pair<const_iterator, bool>{res.first, res.second};
+    }
+
+    template <class M>
+    std::pair<const_iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+    {
+        std::pair<typename Map::iterator, bool> res =
+            map_.try_emplace(k, version_ + 1, std::forward<M>(obj));
+        if (!res.second)
+        {
+            res.first->second.value = std::forward<M>(obj);
+            stamp(res.first);
+        }
+        else
+        {
+            ++version_;
+        }
+        return std::pair<const_iterator, bool>{res.first, res.second};
+    }
+
+    // both hand out a reference to write through, so both count as a write
+    // of the element, also when it is only read
+    mapped_type& operator[](const key_type& k)
+    {
+        std::pair<typename Map::iterator, bool> res = map_.try_emplace(k, version_ + 1);
+        if (!res.second)
+        {
+            stamp(res.first);
+        }
+        else
+        {
+            ++version_;
+        }
+        return res.first->second.value;
+    }
+
+    mapped_type& at(const key_type& k)
+    {
+        typename Map::iterator it = map_.find(k);
+        if (it == map_.end())
+        {
+            throw std::out_of_range("versioned_linked_hash_map::at: key not found");
+        }
+        stamp(it);
+        return it->second.value;
+    }
+
+    const mapped_type& at(const key_type& k) const { return map_.at(k).value; }
+
+
+    const_iterator find(const key_type& k) const { return map_.find(k); }
+    bool contains(const key_type& k) const { return map_.contains(k); }
+    size_type count(const key_type& k) const { return map_.count(k); }
+
+
+    const_iterator erase(const_iterator position)
+    {
+        bury(position->first);
+        return map_.erase(position);
+    }
+
+    size_type erase(const key_type& k)
+    {
+        const_iterator it = map_.find(k);
+        if (it == map_.end())
+        {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    // one write for all: no tombstones, the followers start over from a full copy
+    void clear() noexcept
+    {
+        map_.clear();
+        tombstones_.clear();
+        horizon_ = ++version_;
+    }
+
+    void reserve(size_type n)
+    {
+        map_.reserve(n);
+    }
+
+    void swap(versioned_linked_hash_map& rhs) noexcept
+    {
+        using std::swap;
+        map_.swap(rhs.map_);
+        tombstones_.swap(rhs.tombstones_);
+        swap(tombstone_capacity_, rhs.tombstone_capacity_);
+        swap(version_, rhs.version_);
+        swap(horizon_, rhs.horizon_);
+    }
+
+    friend void swap(versioned_linked_hash_map& lhs, versioned_linked_hash_map& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+private:
+    void stamp(typename Map::iterator it) noexcept
+    {
+        it->second.version = ++version_;
+        map_.move_to_back(it);
+    }
+
+    // the tombstone goes in first, so a throwing copy of the key leaves the element
+    void bury(const key_type& k)
+    {
+        tombstones_.push_back(tombstone{ k, version_ + 1 });
+        ++version_;
+        trim_tombstones();
+    }
+
+    void trim_tombstones() noexcept
+    {
+        while (tombstones_.size() > tombstone_capacity_)
+        {
+            horizon_ = tombstones_.front().version;
+            tombstones_.pop_front();
+        }
+    }
+
+}; // class versioned_linked_hash_map
+
+} // namespace ppstd
+
+#endif // PPSTD_VERSIONED_LINKED_HASH_MAP_H_
@@ -0,0 +1,56 @@
+#include <cstddef>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "../include/concurrent_linked_hash_map.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    concurrent_linked_hash_map<int, int> map(8);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&map, t]
+        {
+            for (int i = 0; i < 5; i++)
+            {
+                map.insert({ t * 100 + i, i });
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    map.visit(101, [](int& v) { v = 1000; });
+    map.erase(202);
+
+    int v = 0;
+    if (map.find(101, v))
+    {
+        std::cout << "101 " << v << "\n";
+    }
+    std::cout << map.size() << " " << map.contains(202) << "\n";
+
+    // the global insertion order, merged from the shards
+    map.for_each([](const int& k, const int& v)
+    {
+        std::cout << k << " " << v << "\n";
+    });
+
+    // integer ids as keys, the hash value has the same type as the key
+    concurrent_linked_hash_map<std::size_t, int> ids(4);
+    ids.insert({ 7, 70 });
+    ids.try_emplace(8, 80);
+    ids.insert_or_assign(7, 700);
+    ids.erase(8);
+    int id = 0;
+    std::cout << ids.find(7, id) << " " << id << " " << ids.contains(8) << " " << ids.size() << "\n";
+
+    std::cout << "hello concurrent\n";
+    return 0;
+}
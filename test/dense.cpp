@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include "../include/dense_linked_hash_map.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    dense_linked_hash_map<std::string, int> map;
+    for (int i = 1; i <= 10; i++)
+    {
+        map.insert({ std::to_string(i), i * 10 });
+    }
+
+    map.erase("3");
+    map.erase(map.begin());
+    map["11"] = 110;
+    for (auto it = map.begin(); it != map.end(); ++it)
+    {
+        std::cout << it->first << " " << it->second << "\n";
+    }
+
+    // drops the tombstones of erased entries
+    map.compact();
+    for (auto it = map.end(); it != map.begin();)
+    {
+        --it;
+        std::cout << it->first << " " << it->second << "\n";
+    }
+
+    std::cout << map.at("7") << " " << map.count("3") << " " << map.size() << "\n";
+
+    map.try_emplace("7", 0);
+    map.insert_or_assign("8", 800);
+    std::cout << map.at("7") << " " << map.at("8") << " " << map.contains("3") << "\n";
+
+    // pages by position, also past tombstones with the positional index
+    map.positional_index(true);
+    map.erase("5");
+    for (auto it = map.nth(3); it != map.nth(6); ++it)
+    {
+        std::cout << map.rank(it) << " " << it->first << "\n";
+    }
+
+    // replaces the contents
+    map = { { "a", 1 }, { "b", 2 } };
+    std::cout << map.size() << " " << map.begin()->first << "\n";
+
+    std::cout << "hello dense\n";
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "../include/expiring_linked_hash_map.hpp"
+
+using namespace ppstd;
+
+// a clock the example moves by hand
+struct manual_clock
+{
+    using duration = std::chrono::seconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<manual_clock>;
+    static const bool is_steady = true;
+
+    static time_point current;
+    static time_point now() { return current; }
+};
+
+manual_clock::time_point manual_clock::current;
+
+int main()
+{
+    // entries live for 10 seconds, nothing is expired on the way
+    expiring_linked_hash_map<std::string, int, manual_clock> sessions(std::chrono::seconds(10), 0);
+    for (int i = 1; i <= 5; i++)
+    {
+        sessions.try_emplace("user" + std::to_string(i), i);
+        manual_clock::current += std::chrono::seconds(1);
+    }
+
+    // user1 and user2 go stale, user3 gets 10 more seconds
+    manual_clock::current += std::chrono::seconds(6);
+    sessions.insert_or_assign("user3", 30);
+    std::cout << sessions.contains("user1") << " " << sessions.size() << "\n";
+
+    // at most one per call
+    std::cout << sessions.expire(manual_clock::now(), 1) << " " << sessions.expire() << "\n";
+    sessions.for_each([](const std::string& k, int v)
+    {
+        std::cout << k << " " << v << "\n";
+    });
+
+    // a shorter ttl also cuts the deadlines already given out
+    sessions.ttl(std::chrono::seconds(2));
+    sessions.try_emplace("user6", 6);
+    manual_clock::current += std::chrono::seconds(2);
+    std::cout << sessions.expire() << " " << sessions.size() << "\n";
+
+    std::cout << "hello expiring\n";
+    return 0;
+}
@@ -0,0 +1,31 @@
+#include <iostream>
+#include "../include/frozen_linked_hash_map.hpp"
+
+using namespace ppstd;
+
+enum class Opcode { open = 12, read = 3, write = 40, close = 7 };
+
+// built by the compiler, no work at startup
+constexpr auto opcodes = make_frozen_linked_hash_map<Opcode, const char*>({
+    { Opcode::open, "open" },
+    { Opcode::read, "read" },
+    { Opcode::write, "write" },
+    { Opcode::close, "close" },
+});
+
+static_assert(opcodes.size() == 4, "four opcodes");
+static_assert(opcodes.contains(Opcode::write), "write is there");
+
+int main()
+{
+    // in the order of declaration
+    for (auto it = opcodes.begin(); it != opcodes.end(); ++it)
+    {
+        std::cout << static_cast<int>(it->first) << " " << it->second << "\n";
+    }
+
+    std::cout << opcodes.at(Opcode::read) << " " << opcodes.count(static_cast<Opcode>(5)) << "\n";
+
+    std::cout << "hello frozen\n";
+    return 0;
+}
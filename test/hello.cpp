@@ -1,8 +1,64 @@
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
 #include "../include/linked_hash_map.hpp"
 
 using namespace ppstd;
 
+// counts its calls, to show which operations hash the key
+struct counting_hash
+{
+    static int calls;
+
+    template <class K>
+    std::size_t operator()(const K& k) const
+    {
+        ++calls;
+        return std::hash<K>()(k);
+    }
+};
+
+int counting_hash::calls = 0;
+
+// a piece of a buffer, looked up without making a std::string of it
+struct name_view
+{
+    const char* data;
+    std::size_t size;
+};
+
+struct name_hash
+{
+    using is_transparent = void;
+
+    std::size_t operator()(name_view v) const
+    {
+        std::size_t h = 14695981039346656037ull;
+        for (std::size_t i = 0; i < v.size; i++)
+        {
+            h = (h ^ static_cast<unsigned char>(v.data[i])) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    std::size_t operator()(const std::string& s) const { return (*this)(name_view{ s.data(), s.size() }); }
+};
+
+struct name_equal
+{
+    using is_transparent = void;
+
+    bool operator()(const std::string& a, const std::string& b) const { return a == b; }
+    bool operator()(const std::string& a, name_view b) const
+    {
+        return a.size() == b.size && std::memcmp(a.data(), b.data, b.size) == 0;
+    }
+    bool operator()(name_view a, const std::string& b) const { return (*this)(b, a); }
+};
+
 int main()
 {
     linked_hash_map<int, double>::iterator free_it;
@@ -68,6 +124,37 @@ int main()
     map[20] = 200000.0;
     std::cout << map[20] << "\n";
 
+    auto tried = map.try_emplace(20, 1.0);
+    std::cout << tried.second << " " << tried.first->second << "\n";
+    map.insert_or_assign(20, 2.0);
+    std::cout << map[20] << "\n";
+
+    map.move_to_front(map.find(20));
+    map.move_before(map.find(20), map.find(16));
+    std::cout << map.begin()->first << " " << std::next(map.begin())->first << "\n";
+
+    // a hinted insert into a full bounded map evicts the eldest other element
+    linked_hash_map<int, double> bounded;
+    bounded.max_entries(2);
+    bounded[1] = 1.0;
+    bounded[2] = 2.0;
+    auto front = bounded.insert_at(bounded.cbegin(), { 3, 3.0 }).first;
+    std::cout << front->first << " " << bounded.size() << "\n";
+    auto hinted = bounded.try_emplace(bounded.cbegin(), 4, 4.0);
+    std::cout << hinted->first << " " << bounded.size() << "\n";
+    for (auto it = bounded.begin(); it != bounded.end(); ++it)
+    {
+        std::cout << it->first << " " << it->second << "\n";
+    }
+
+    // pages by position in O(log n) with the positional index
+    map.positional_index(true);
+    map.erase(5);
+    for (auto it = map.nth(4); it != map.nth(7); ++it)
+    {
+        std::cout << map.rank(it) << " " << it->first << "\n";
+    }
+
     linked_hash_map<int, double> map1;
     map1.insert({ 1, 10 });
     linked_hash_map<int, double> map2;
@@ -86,6 +173,13 @@ int main()
     {
         std::cout << "uneq as expected\n";
     }
+    map2[2] = 20;
+    map2.move_to_front(map2.find(2));
+    if (map1 != map2 && equal_unordered(map1, map2) && map1.key_fingerprint() == map2.key_fingerprint())
+    {
+        std::cout << "eq unordered as expected\n";
+    }
+    map2[2] = 200;
     swap(map1, map2);
     for (auto map1_iter = map1.begin(), map2_iter = map2.begin(); 
         map1_iter != map1.end() && map2_iter != map2.end();
@@ -110,6 +204,144 @@ int main()
     linked_hash_map<double, int> ohbkmap = 20;
     std::cout << ohbkmap.bucket_count() << "\n";
 
+    // erase by iterator unlinks the node without hashing its key
+    linked_hash_map<int, int, counting_hash> counted;
+    counted.insert({ {1, 1}, {2, 2}, {3, 3} });
+    auto two = counted.find(2);
+    counting_hash::calls = 0;
+    counted.erase(two);
+    counted.erase(counted.begin());
+    std::cout << counting_hash::calls << " " << counted.size() << " " << counted.begin()->first << "\n";
+
+    // a transparent Hash and Pred take other key types for find, count, at and erase
+    const char* names = "alice,bob,carol";
+    linked_hash_map<std::string, int, name_hash, name_equal> ages{ {"alice", 30}, {"bob", 40}, {"carol", 50} };
+    const name_view bob{ names + 6, 3 };
+    std::cout << ages.find(bob)->second << " " << ages.count(bob) << " " << ages.at(name_view{ names, 5 }) << "\n";
+    std::cout << ages.erase(bob) << " " << ages.count(bob) << " " << ages.size() << "\n";
+
+    // string keys keep their hash values: a rehash and the lookups with a known hash call no Hash
+    linked_hash_map<std::string, int, counting_hash> cached;
+    const std::size_t h = counting_hash()(std::string("key"));
+    counting_hash::calls = 0;
+    cached.try_emplace_hashed(h, "key", 1);
+    cached.insert({ {"a", 2}, {"b", 3} });
+    cached.rehash(64);
+    std::cout << counting_hash::calls << " " << cached.find("key", h)->second << " " << cached.contains("a", h)
+        << " " << counting_hash::calls << "\n";
+
+    // a range insert sizes the buckets once, so no int key is hashed again by a rehash
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < 1000; i++)
+    {
+        pairs.emplace_back(i, i);
+    }
+    linked_hash_map<int, int, counting_hash> bulk, one_by_one;
+    counting_hash::calls = 0;
+    bulk.insert(pairs.begin(), pairs.end());
+    const int bulk_calls = counting_hash::calls;
+    counting_hash::calls = 0;
+    for (const auto& kv : pairs)
+    {
+        one_by_one.insert(kv);
+    }
+    const int one_by_one_calls = counting_hash::calls;
+    std::cout << bulk_calls << " " << one_by_one_calls << " " << (bulk == one_by_one) << "\n";
+
+    // node handles move the elements between maps without reallocating them
+    linked_hash_map<std::string, int> from{ {"x", 1}, {"y", 2}, {"z", 3} };
+    linked_hash_map<std::string, int> to{ {"z", 30} };
+    const int* y_address = &from.at("y");
+    auto handle = from.extract("y");
+    handle.key() = "w";
+    auto placed = to.insert(std::move(handle));
+    std::cout << placed.inserted << " " << (&placed.position->second == y_address) << " " << handle.empty() << "\n";
+    to.merge(from);
+    for (const auto& kv : to)
+    {
+        std::cout << kv.first << kv.second << " ";
+    }
+    std::cout << "| " << from.size() << " " << from.begin()->first << "\n";
+
+    // compact(max_work) relinks a few nodes per call and keeps the order
+    linked_hash_map<int, int> churned;
+    for (int i = 0; i < 10; i++)
+    {
+        churned[i] = i;
+    }
+    for (int i = 0; i < 10; i += 2)
+    {
+        churned.erase(i);
+        churned[i + 10] = i + 10;
+    }
+    churned.compact(3);
+    std::cout << churned.compaction_in_progress() << " " << (churned.memory_usage().spare > 0) << " ";
+    int passes = 1;
+    while (!churned.compact(3))
+    {
+        passes++;
+    }
+    std::cout << passes << " " << churned.compaction_in_progress() << " " << churned.memory_usage().spare << " |";
+    for (const auto& kv : churned)
+    {
+        std::cout << " " << kv.first;
+    }
+    std::cout << "\n";
+
+    // with incremental rehash a growth moves a few buckets per insert, lookups see both arrays
+    linked_hash_map<int, int> gradual;
+    gradual.reserve(16);
+    gradual.incremental_rehash(true);
+    int n = 0;
+    while (!gradual.rehash_in_progress())
+    {
+        gradual[n] = n;
+        n++;
+    }
+    int found = 0;
+    for (int i = 0; i < n; i++)
+    {
+        found += gradual.count(i);
+    }
+    std::cout << n << " " << found << " " << gradual.bucket_count();
+    while (gradual.rehash_in_progress())
+    {
+        gradual[n] = n;
+        n++;
+    }
+    std::cout << " " << n << " " << gradual.rehash_in_progress();
+    // and shrink_to_fit() gives back the buckets after the erases
+    gradual.erase(gradual.nth(4), gradual.end());
+    gradual.shrink_to_fit();
+    std::cout << " " << gradual.bucket_count() << " " << gradual.rbegin()->first << "\n";
+
+    // find_many and contains_many look up whole batches of keys, misses give end() and false
+    std::vector<int> wanted;
+    for (int i = 0; i < 40; i++)
+    {
+        wanted.push_back(i * 3);
+    }
+    std::vector<linked_hash_map<int, int>::iterator> hits;
+    gradual.find_many(wanted.begin(), wanted.end(), std::back_inserter(hits));
+    std::vector<bool> present;
+    bulk.contains_many(wanted.begin(), wanted.end(), std::back_inserter(present));
+    int hit_count = 0;
+    for (const auto& it : hits)
+    {
+        hit_count += it != gradual.end() ? 1 : 0;
+    }
+    std::cout << hits.size() << " " << hit_count << " " << hits[1]->first << " " << (hits[2] == gradual.end())
+        << " " << std::count(present.begin(), present.end(), true) << "\n";
+
+    // memory_usage() splits the bytes of a map; the string keys pay for their cached hash
+    const linked_hash_map_memory used = bulk.memory_usage();
+    std::cout << (used.payload == bulk.size() * sizeof(std::pair<const int, int>)) << " "
+        << (used.node_overhead == bulk.size() * bulk.node_overhead_bytes()) << " "
+        << (used.buckets == bulk.bucket_count() * sizeof(void*)) << " "
+        << (used.total() == used.buckets + used.node_overhead + used.payload + used.spare) << " "
+        << linked_hash_map<std::string, int>::node_overhead_bytes() - linked_hash_map<int, int>::node_overhead_bytes()
+        << "\n";
+
     std::cout << "hello world\n";
     return 0;
 }
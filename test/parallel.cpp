@@ -0,0 +1,47 @@
+#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "../include/linked_hash_map.hpp"
+#include "../include/parallel_for_each.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    linked_hash_map<int, long long> map;
+    for (int i = 1; i <= 100000; i++)
+    {
+        map.insert({ i, i });
+    }
+
+    std::atomic<long long> total{ 0 };
+    parallel_for_each(parallel_policy(4), map, [&total](const std::pair<const int, long long>& kv)
+    {
+        total += kv.second;
+    });
+    std::cout << total << "\n";
+
+    // one partial result per chunk, the chunks are in the insertion order
+    const parallel_policy policy(4, 2);
+    std::vector<int> firsts(8);
+    parallel_for_each_chunk(policy, map,
+        [&firsts](linked_hash_map<int, long long>::iterator first,
+            linked_hash_map<int, long long>::iterator last, std::size_t chunk)
+    {
+        firsts[chunk] = first == last ? 0 : first->first;
+    });
+    for (int first : firsts)
+    {
+        std::cout << first << "\n";
+    }
+
+    // with the positional index the split points are found without a walk
+    map.positional_index(true);
+    map.erase(3);
+    for (const auto& chunk : map.chunks(3))
+    {
+        std::cout << chunk.first->first << " " << std::distance(chunk.first, chunk.second) << "\n";
+    }
+    return 0;
+}
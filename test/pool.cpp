@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "../include/linked_hash_map.hpp"
+#include "../include/pool_allocator.hpp"
+
+using namespace ppstd;
+
+// counts the calls of the global operator new, to show what the allocators save
+static int news = 0;
+
+void* operator new(std::size_t size)
+{
+    ++news;
+    if (void* p = std::malloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+template <class Map>
+int build(Map& map, int from)
+{
+    const int before = news;
+    for (int i = from; i < from + 100; i++)
+    {
+        map[i] = i;
+    }
+    return news - before;
+}
+
+template <class Map>
+void erase_all(Map& map)
+{
+    for (auto it = map.begin(); it != map.end();)
+    {
+        it = map.erase(it);
+    }
+}
+
+int main()
+{
+    using pool_alloc = pool_allocator<std::pair<const int, int>>;
+    using arena_alloc = arena_allocator<std::pair<const int, int>>;
+
+    // 100 nodes in two chunks of 64 blocks (plus the pool's own bookkeeping),
+    // then the rebuild takes the freed blocks, the last one freed first
+    node_pool pool(64);
+    linked_hash_map<int, int, std::hash<int>, std::equal_to<int>, pool_alloc> pooled{ pool_alloc(pool) };
+    pooled.reserve(100);
+    std::cout << build(pooled, 0) << " ";
+    const int* last = &pooled.at(99);
+    erase_all(pooled);
+    std::cout << build(pooled, 100) << " " << (&pooled.at(100) == last) << " " << pooled.size() << "\n";
+
+    // the arena never reuses a block: the nodes and then the rebuilt ones bump
+    // through the chunk that reserve() opened for the buckets
+    arena monotonic;
+    linked_hash_map<int, int, std::hash<int>, std::equal_to<int>, arena_alloc> bumped{ arena_alloc(monotonic) };
+    bumped.reserve(100);
+    std::cout << build(bumped, 0) << " ";
+    const int* first = &bumped.at(0);
+    erase_all(bumped);
+    std::cout << build(bumped, 100) << " " << (&bumped.at(100) > first) << " " << bumped.size() << "\n";
+
+    // the plain map allocates one node per element
+    linked_hash_map<int, int> plain;
+    plain.reserve(100);
+    std::cout << build(plain, 0) << "\n";
+
+    std::cout << "hello pool\n";
+    return 0;
+}
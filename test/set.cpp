@@ -0,0 +1,45 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/linked_hash_set.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    // removes the duplicates, the first occurrence of each word keeps its place
+    std::vector<std::string> words{ "to", "be", "or", "not", "to", "be" };
+    linked_hash_set<std::string> seen(words.begin(), words.end());
+    for (const std::string& w : seen)
+    {
+        std::cout << w << " ";
+    }
+    std::cout << "\n";
+
+    seen.erase("or");
+    seen.insert("question");
+    std::cout << seen.contains("be") << " " << seen.contains("or") << " " << seen.size() << "\n";
+    for (auto it = seen.rbegin(); it != seen.rend(); ++it)
+    {
+        std::cout << *it << " ";
+    }
+    std::cout << "\n";
+
+    // a bounded LRU set: the new key stays even when the hint puts it at the front
+    linked_hash_set<int> recent;
+    recent.access_order(true);
+    recent.max_entries(3);
+    recent.eviction_callback([](const int& k) { std::cout << "evicted " << k << "\n"; });
+    recent.insert({ 1, 2, 3 });
+    recent.find(1);
+    recent.insert(4);
+    std::cout << *recent.insert(recent.cbegin(), 5) << " " << recent.size() << "\n";
+    for (int k : recent)
+    {
+        std::cout << k << " ";
+    }
+    std::cout << "\n";
+
+    std::cout << "hello set\n";
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <string>
+#include "../include/small_linked_hash_map.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    // up to 4 elements inline, found by a linear scan
+    small_linked_hash_map<std::string, int, 4> map;
+    for (int i = 1; i <= 4; i++)
+    {
+        map.insert({ std::to_string(i), i * 10 });
+    }
+    map.erase("2");
+    map["5"] = 50;
+    std::cout << (map.is_inline() ? "inline" : "hashed") << "\n";
+
+    // the 5th element moves them all to a linked_hash_map
+    map["6"] = 60;
+    std::cout << (map.is_inline() ? "inline" : "hashed") << "\n";
+    for (auto it = map.begin(); it != map.end(); ++it)
+    {
+        std::cout << it->first << " " << it->second << "\n";
+    }
+
+    // and back, once they fit again
+    map.erase("1");
+    map.shrink_to_fit();
+    std::cout << (map.is_inline() ? "inline" : "hashed") << " " << map.at("6") << " " << map.size() << "\n";
+
+    // the element that spills the map may be copied from an inline one
+    small_linked_hash_map<int, std::string, 2> names;
+    names[1] = std::string(40, 'a');
+    names[2] = std::string(40, 'b');
+    names.insert_or_assign(3, names.at(1));
+    names.try_emplace(4, names.at(2));
+    std::cout << (names.is_inline() ? "inline" : "hashed") << " " << names.at(1).size() << " "
+        << names.at(3).size() << " " << names.at(4)[0];
+    for (const auto& kv : names)
+    {
+        std::cout << " " << kv.first;
+    }
+    std::cout << "\n";
+
+    std::cout << "hello small\n";
+    return 0;
+}
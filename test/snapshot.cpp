@@ -0,0 +1,41 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../include/linked_hash_map_snapshot.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    linked_hash_map<std::string, int> names;
+    names["three"] = 3;
+    names["one"] = 1;
+    names["two"] = 2;
+
+    std::stringstream stream;
+    write_snapshot(stream, names);
+    linked_hash_map<std::string, int> names_copy;
+    read_snapshot(stream, names_copy);
+    for (auto it = names_copy.begin(); it != names_copy.end(); ++it)
+    {
+        std::cout << it->first << " " << it->second << "\n";
+    }
+
+    // trivially copyable keys and values load straight from a buffer
+    linked_hash_map<int, double> squares;
+    for (int i = 5; i > 0; i--)
+    {
+        squares[i] = i * i;
+    }
+    std::ostringstream out;
+    write_snapshot(out, squares);
+    const std::string bytes = out.str();
+    linked_hash_map<int, double> squares_copy;
+    load_snapshot(bytes.data(), bytes.size(), squares_copy);
+    for (auto it = squares_copy.begin(); it != squares_copy.end(); ++it)
+    {
+        std::cout << it->first << " " << it->second << "\n";
+    }
+    std::cout << (squares_copy == squares ? "eq as expected\n" : "uneq\n");
+    return 0;
+}
@@ -0,0 +1,36 @@
+#define PPSTD_LINKED_HASH_MAP_STATS
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "../include/linked_hash_map.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    // every map counts its own work once PPSTD_LINKED_HASH_MAP_STATS is defined
+    linked_hash_map<std::string, int> map;
+    for (int i = 0; i < 100; i++)
+    {
+        map.insert({ std::to_string(i), i });
+    }
+    linked_hash_map_stats s = map.stats();
+    std::cout << s.hash_calls << " " << s.node_allocations << " " << (s.rehashes > 0) << "\n";
+
+    // a hit and a miss of at(), then an erase by iterator, which hashes nothing
+    map.reset_stats();
+    map.at("7");
+    try
+    {
+        map.at("missing");
+    }
+    catch (const std::out_of_range&)
+    {
+    }
+    map.erase(map.begin());
+    s = map.stats();
+    std::cout << s.hash_calls << " " << s.lookups << " " << s.at_misses << " " << s.node_frees << "\n";
+
+    std::cout << "hello stats\n";
+    return 0;
+}
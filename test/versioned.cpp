@@ -0,0 +1,47 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include "../include/versioned_linked_hash_map.hpp"
+
+using namespace ppstd;
+
+int main()
+{
+    versioned_linked_hash_map<std::string, int> leader;
+    std::map<std::string, int> follower;
+
+    leader.insert({ "a", 1 });
+    leader.insert({ "b", 2 });
+    leader.insert({ "c", 3 });
+    for (auto it = leader.begin(); it != leader.end(); ++it)
+    {
+        follower[it->first] = it->second.value;
+    }
+    const auto synced = leader.version();
+
+    // two writes and an erase later, only those three are sent
+    leader["a"] = 10;
+    leader.insert_or_assign("d", 4);
+    leader.erase("b");
+
+    auto erased = leader.erased_since(synced);
+    for (auto it = erased.first; it != erased.second; ++it)
+    {
+        follower.erase(it->key);
+        std::cout << "erase " << it->key << " @" << it->version << "\n";
+    }
+    auto changes = leader.changes_since(synced);
+    for (auto it = changes.first; it != changes.second; ++it)
+    {
+        follower[it->first] = it->second.value;
+        std::cout << "set " << it->first << " " << it->second.value << " @" << it->second.version << "\n";
+    }
+
+    for (auto& kv : follower)
+    {
+        std::cout << kv.first << " " << kv.second << "\n";
+    }
+
+    std::cout << "hello versioned\n";
+    return 0;
+}